@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Reports, for the std::string and buffer forms of to_puny_code/from_puny_code, the time, heap allocations and bytes
+// allocated per call and the heap high water mark of each batch.  Run it before and after a change to see whether
+// allocations crept back into the conversion paths.  Usage: allocation_benchmark [HOSTNAMES_FILE]
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "counting_allocator.h"
+#include "puny_coder.h"
+
+namespace {
+	std::vector<std::string> default_corpus( ) {
+		return { "example.com", "bücher.ch", "happy快乐.cn", "快乐.中国", "www.ハンドボールサムズ.com", "🦄.com" };
+	}
+
+	std::vector<std::string> load_corpus( std::string const & path ) {
+		std::ifstream in( path );
+		std::vector<std::string> result;
+		std::string line;
+		while( std::getline( in, line ) ) {
+			if( !line.empty( ) ) {
+				result.push_back( std::move( line ) );
+			}
+		}
+		return result;
+	}
+
+	template<typename Function>
+	void measure( char const * name, std::vector<std::string> const & inputs, size_t batch_size, Function f ) {
+		daw::testing::allocation_scope scope;
+		auto const start = std::chrono::steady_clock::now( );
+		for( size_t n = 0; n < batch_size; ++n ) {
+			f( inputs[n % inputs.size( )] );
+		}
+		std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now( ) - start;
+		auto const calls = static_cast<double>( batch_size );
+		std::cout << std::left << std::setw( 24 ) << name << std::right << std::fixed << std::setprecision( 1 )
+		          << std::setw( 10 ) << elapsed.count( ) / calls << " ns" << std::setprecision( 3 ) << std::setw( 10 )
+		          << static_cast<double>( scope.allocations( ) ) / calls << " allocs" << std::setprecision( 1 )
+		          << std::setw( 10 ) << static_cast<double>( scope.bytes( ) ) / calls << " bytes"
+		          << std::setw( 12 ) << scope.high_water( ) << " high water\n";
+	}
+
+	void run( std::vector<std::string> const & unicode, std::vector<std::string> const & ace, size_t batch_size ) {
+		std::array<char, 1024> buffer;
+		std::vector<std::string> kept;
+		kept.reserve( batch_size );
+		measure( "to_puny_code", unicode, batch_size, [&]( std::string const & host ) { kept.push_back( daw::to_puny_code( host ) ); } );
+		kept.clear( );
+		measure( "to_puny_code buffer", unicode, batch_size, [&]( std::string const & host ) {
+			daw::to_puny_code( host, buffer.data( ), buffer.size( ) );
+		} );
+		measure( "from_puny_code", ace, batch_size, [&]( std::string const & host ) { kept.push_back( daw::from_puny_code( host ) ); } );
+		kept.clear( );
+		measure( "from_puny_code buffer", ace, batch_size, [&]( std::string const & host ) {
+			daw::from_puny_code( host, buffer.data( ), buffer.size( ) );
+		} );
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	auto const unicode = argc > 1 ? load_corpus( argv[1] ) : default_corpus( );
+	if( unicode.empty( ) ) {
+		std::cerr << "No hostnames\n";
+		return EXIT_FAILURE;
+	}
+	std::vector<std::string> ace;
+	for( auto const & host : unicode ) {
+		ace.push_back( daw::to_puny_code( host ) );
+	}
+	for( bool cached : { true, false } ) {
+		daw::set_label_cache_capacity( cached ? 4096 : 0 );
+		std::cout << ( cached ? "Label caches on\n" : "Label caches off\n" );
+		for( size_t batch_size : { 1000, 100000 } ) {
+			std::cout << "Batch of " << batch_size << " (string results are kept until the batch ends)\n";
+			run( unicode, ace, batch_size );
+		}
+	}
+	return EXIT_SUCCESS;
+}
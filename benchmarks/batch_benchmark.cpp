@@ -0,0 +1,152 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Compares encode_labels/decode_labels with calling to_puny_code/from_puny_code on each label, with the label caches
+// off, and checks that both give the same results.  The labels are drawn at random, with a fixed seed, from a few
+// scripts and are 15 to 30 code points long.  If a batch engine is not faster than the scalar loop on a given machine
+// it is not worth having.  Usage: batch_benchmark [--labels N] [--repeats N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+
+namespace {
+	void append_utf8( std::string & out, uint32_t cp ) {
+		if( cp < 0x80 ) {
+			out += static_cast<char>( cp );
+		} else if( cp < 0x800 ) {
+			out += static_cast<char>( 0xC0 | ( cp >> 6 ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		} else {
+			out += static_cast<char>( 0xE0 | ( cp >> 12 ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		}
+	}
+
+	// Labels mixing ASCII with one script each, kept to those whose ACE form is a valid 63 octet label
+	std::vector<std::string> make_labels( size_t count ) {
+		struct script_t {
+			uint32_t first;
+			uint32_t size;
+		};
+		static script_t const scripts[] = { { 0xE0, 0x20 }, { 0x430, 0x20 }, { 0x3B1, 0x19 }, { 0x5D0, 0x1B }, { 0x3041, 0x56 } };
+		std::mt19937 rng( 3492 );
+		std::vector<std::string> result;
+		result.reserve( count );
+		while( result.size( ) < count ) {
+			auto const & script = scripts[rng( ) % ( sizeof( scripts ) / sizeof( scripts[0] ) )];
+			auto const length = 15 + rng( ) % 16;
+			std::string label;
+			for( size_t n = 0; n < length; ++n ) {
+				append_utf8( label, rng( ) % 3 == 0 ? 'a' + rng( ) % 26 : script.first + rng( ) % script.size );
+			}
+			if( daw::to_puny_code( label ).size( ) <= 63 ) {
+				result.push_back( std::move( label ) );
+			}
+		}
+		return result;
+	}
+
+	template<typename Function>
+	double best_of( size_t repeats, Function f ) {
+		double best = 0.0;
+		for( size_t n = 0; n < repeats; ++n ) {
+			auto const start = std::chrono::steady_clock::now( );
+			f( );
+			std::chrono::duration<double, std::milli> const elapsed = std::chrono::steady_clock::now( ) - start;
+			best = n == 0 ? elapsed.count( ) : std::min( best, elapsed.count( ) );
+		}
+		return best;
+	}
+
+	void report( char const * name, double scalar, double batch ) {
+		std::cout << std::left << std::setw( 16 ) << name << std::right << std::fixed << std::setprecision( 1 )
+		          << std::setw( 10 ) << scalar << " ms scalar" << std::setw( 10 ) << batch << " ms batch"
+		          << std::setprecision( 2 ) << std::setw( 8 ) << scalar / batch << "x\n";
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	size_t label_count = 200000;
+	size_t repeats = 5;
+	for( int n = 1; n < argc; n += 2 ) {
+		std::string const arg = argv[n];
+		if( n + 1 < argc && arg == "--labels" ) {
+			label_count = std::stoul( argv[n + 1] );
+		} else if( n + 1 < argc && arg == "--repeats" ) {
+			repeats = std::stoul( argv[n + 1] );
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--labels N] [--repeats N]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if( label_count == 0 || repeats == 0 ) {
+		std::cerr << "--labels and --repeats must be at least 1\n";
+		return EXIT_FAILURE;
+	}
+	daw::set_label_cache_capacity( 0 );
+	auto const unicode = make_labels( label_count );
+	std::vector<std::string> ace;
+	ace.reserve( unicode.size( ) );
+	for( auto const & label : unicode ) {
+		ace.push_back( daw::to_puny_code( label ) );
+	}
+	std::vector<daw::string_view> unicode_views( unicode.begin( ), unicode.end( ) );
+	std::vector<daw::string_view> ace_views( ace.begin( ), ace.end( ) );
+
+	std::vector<std::string> results( unicode.size( ) );
+	auto const encode_scalar = best_of( repeats, [&]( ) {
+		for( size_t n = 0; n < unicode.size( ); ++n ) {
+			results[n] = daw::to_puny_code( unicode_views[n] );
+		}
+	} );
+	auto const encode_batch = best_of( repeats, [&]( ) { results = daw::encode_labels( unicode_views ); } );
+	bool ok = results == ace;
+	auto const decode_scalar = best_of( repeats, [&]( ) {
+		for( size_t n = 0; n < ace.size( ); ++n ) {
+			results[n] = daw::from_puny_code( ace_views[n] );
+		}
+	} );
+	auto const decode_batch = best_of( repeats, [&]( ) { results = daw::decode_labels( ace_views ); } );
+	ok = ok && results == unicode;
+
+	std::cout << unicode.size( ) << " labels of 15 to 30 code points, label caches off, best of " << repeats << '\n';
+	report( "encode_labels", encode_scalar, encode_batch );
+	report( "decode_labels", decode_scalar, decode_batch );
+	if( !ok ) {
+		std::cout << "The batch results differ from the scalar ones\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
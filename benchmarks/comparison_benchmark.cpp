@@ -0,0 +1,349 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Runs one corpus through to_puny_code/from_puny_code and through reference implementations: the RFC 3492 sample
+// code (vendored in rfc3492/) and, when found at configure time, libidn2 and ICU's UTS #46 uidna.  Hostnames are
+// grouped by the kind of characters they contain and each engine's throughput is reported relative to this
+// library's for every group, along with how many results differed from ours or were rejected.  libidn2 and ICU
+// also map and validate (IDNA2008/UTS #46), which is part of what a service replacing them would stop paying for.
+// Usage: comparison_benchmark [HOSTNAMES_FILE]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef PUNY_CODER_HAVE_IDN2
+#include <idn2.h>
+#endif
+#ifdef PUNY_CODER_HAVE_ICU
+#include <unicode/uidna.h>
+#endif
+
+#include "puny_coder.h"
+#include "rfc3492/punycode.h"
+
+namespace {
+	// Returns false if the engine rejected the input
+	using convert_fn = std::function<bool( std::string const &, std::string & )>;
+
+	struct engine_t {
+		std::string name;
+		convert_fn encode;
+		convert_fn decode;
+		std::function<void( )> setup;
+	};
+
+	bool decode_utf8( std::string const & in, std::vector<punycode_uint> & out ) {
+		out.clear( );
+		for( size_t pos = 0; pos < in.size( ); ) {
+			auto const lead = static_cast<unsigned char>( in[pos] );
+			size_t const size = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+			if( pos + size > in.size( ) ) {
+				return false;
+			}
+			punycode_uint cp = size == 1 ? lead : size == 2 ? lead & 0x1Fu : size == 3 ? lead & 0x0Fu : lead & 0x07u;
+			for( size_t n = 1; n < size; ++n ) {
+				cp = ( cp << 6 ) | ( static_cast<unsigned char>( in[pos + n] ) & 0x3Fu );
+			}
+			out.push_back( cp );
+			pos += size;
+		}
+		return true;
+	}
+
+	void append_utf8( std::string & out, punycode_uint cp ) {
+		if( cp < 0x80 ) {
+			out += static_cast<char>( cp );
+		} else if( cp < 0x800 ) {
+			out += static_cast<char>( 0xC0 | ( cp >> 6 ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		} else if( cp < 0x10000 ) {
+			out += static_cast<char>( 0xE0 | ( cp >> 12 ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		} else {
+			out += static_cast<char>( 0xF0 | ( cp >> 18 ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		}
+	}
+
+	// The sample code converts single labels of code points; this adds the label splitting and xn-- handling
+	template<typename Convert>
+	bool for_each_label( std::string const & host, std::string & out, Convert convert ) {
+		out.clear( );
+		size_t first = 0;
+		while( true ) {
+			auto const dot = std::min( host.find( '.', first ), host.size( ) );
+			if( !convert( host.substr( first, dot - first ), out ) ) {
+				return false;
+			}
+			if( dot == host.size( ) ) {
+				return true;
+			}
+			out += '.';
+			first = dot + 1;
+		}
+	}
+
+	bool rfc3492_encode( std::string const & host, std::string & out ) {
+		std::vector<punycode_uint> code_points;
+		return for_each_label( host, out, [&]( std::string const & label, std::string & result ) {
+			if( std::all_of( label.begin( ), label.end( ), []( char c ) { return static_cast<unsigned char>( c ) < 0x80; } ) ) {
+				result += label;
+				return true;
+			}
+			if( !decode_utf8( label, code_points ) ) {
+				return false;
+			}
+			std::array<char, 256> buffer;
+			punycode_uint size = buffer.size( );
+			if( punycode_encode( static_cast<punycode_uint>( code_points.size( ) ), code_points.data( ), nullptr, &size, buffer.data( ) ) != punycode_success ) {
+				return false;
+			}
+			result += "xn--";
+			result.append( buffer.data( ), size );
+			return true;
+		} );
+	}
+
+	bool rfc3492_decode( std::string const & host, std::string & out ) {
+		return for_each_label( host, out, []( std::string const & label, std::string & result ) {
+			if( label.compare( 0, 4, "xn--" ) != 0 ) {
+				result += label;
+				return true;
+			}
+			std::array<punycode_uint, 256> buffer;
+			punycode_uint size = buffer.size( );
+			if( punycode_decode( static_cast<punycode_uint>( label.size( ) - 4 ), label.data( ) + 4, &size, buffer.data( ), nullptr ) != punycode_success ) {
+				return false;
+			}
+			for( punycode_uint n = 0; n < size; ++n ) {
+				append_utf8( result, buffer[n] );
+			}
+			return true;
+		} );
+	}
+
+	std::vector<engine_t> make_engines( ) {
+		std::vector<engine_t> result;
+		auto const set_cache = []( size_t capacity ) {
+			return [capacity]( ) { daw::set_label_cache_capacity( capacity ); };
+		};
+		auto const guarded = []( std::string ( *f )( daw::string_view ) ) {
+			return [f]( std::string const & in, std::string & out ) {
+				try {
+					out = f( in );
+					return true;
+				} catch( std::exception const & ) {
+					return false;
+				}
+			};
+		};
+		result.push_back( { "puny_coder", guarded( daw::to_puny_code ), guarded( daw::from_puny_code ), set_cache( 4096 ) } );
+		result.push_back( { "puny_coder (no cache)", guarded( daw::to_puny_code ), guarded( daw::from_puny_code ), set_cache( 0 ) } );
+		result.push_back( { "rfc3492 sample", rfc3492_encode, rfc3492_decode, [ ]( ) { } } );
+#ifdef PUNY_CODER_HAVE_IDN2
+		result.push_back( { "libidn2",
+		                    []( std::string const & in, std::string & out ) {
+			                    char * p = nullptr;
+			                    if( idn2_to_ascii_8z( in.c_str( ), &p, IDN2_NONTRANSITIONAL ) != IDN2_OK ) {
+				                    return false;
+			                    }
+			                    out = p;
+			                    idn2_free( p );
+			                    return true;
+		                    },
+		                    []( std::string const & in, std::string & out ) {
+			                    char * p = nullptr;
+			                    if( idn2_to_unicode_8z8z( in.c_str( ), &p, 0 ) != IDN2_OK ) {
+				                    return false;
+			                    }
+			                    out = p;
+			                    idn2_free( p );
+			                    return true;
+		                    },
+		                    [ ]( ) { } } );
+#endif
+#ifdef PUNY_CODER_HAVE_ICU
+		static UIDNA * idna = [ ]( ) {
+			UErrorCode error = U_ZERO_ERROR;
+			auto const result = uidna_openUTS46( UIDNA_NONTRANSITIONAL_TO_ASCII | UIDNA_NONTRANSITIONAL_TO_UNICODE, &error );
+			return U_FAILURE( error ) ? nullptr : result;
+		}( );
+		if( idna ) {
+			auto const icu = []( decltype( &uidna_nameToASCII_UTF8 ) f ) {
+				return [f]( std::string const & in, std::string & out ) {
+					std::array<char, 1024> buffer;
+					UErrorCode error = U_ZERO_ERROR;
+					UIDNAInfo info = UIDNA_INFO_INITIALIZER;
+					auto const size = f( idna, in.data( ), static_cast<int32_t>( in.size( ) ), buffer.data( ),
+					                     static_cast<int32_t>( buffer.size( ) ), &info, &error );
+					if( U_FAILURE( error ) || info.errors != 0 ) {
+						return false;
+					}
+					out.assign( buffer.data( ), static_cast<size_t>( size ) );
+					return true;
+				};
+			};
+			result.push_back( { "ICU uidna", icu( uidna_nameToASCII_UTF8 ), icu( uidna_nameToUnicodeUTF8 ), [ ]( ) { } } );
+		}
+#endif
+		return result;
+	}
+
+	// Grouped by the highest code point, which decides how much Bootstring work a name needs
+	std::string classify( std::string const & host ) {
+		std::vector<punycode_uint> code_points;
+		if( !decode_utf8( host, code_points ) ) {
+			return "invalid";
+		}
+		auto const highest = code_points.empty( ) ? 0 : *std::max_element( code_points.begin( ), code_points.end( ) );
+		if( highest < 0x80 ) {
+			return "ascii";
+		} else if( highest < 0x250 ) {
+			return "latin";
+		} else if( highest >= 0x400 && highest < 0x530 ) {
+			return "cyrillic";
+		} else if( highest >= 0x2E80 && highest < 0xD7B0 ) {
+			return "cjk";
+		} else if( highest >= 0x1F000 ) {
+			return "emoji";
+		}
+		return "other";
+	}
+
+	std::vector<std::string> default_corpus( ) {
+		std::vector<std::string> result;
+		for( size_t n = 0; n < 2000; ++n ) {
+			auto const id = std::to_string( n );
+			result.push_back( "host" + id + ".example.com" );
+			result.push_back( "bücher" + id + ".example.de" );
+			result.push_back( "пример" + id + ".испытание" );
+			result.push_back( "例え" + id + ".テスト" );
+			result.push_back( "😀" + id + ".example.com" );
+		}
+		return result;
+	}
+
+	std::vector<std::string> load_corpus( std::string const & path ) {
+		std::ifstream in( path );
+		std::vector<std::string> result;
+		std::string line;
+		while( std::getline( in, line ) ) {
+			if( !line.empty( ) ) {
+				result.push_back( std::move( line ) );
+			}
+		}
+		return result;
+	}
+
+	struct measurement {
+		double ns_per_name = 0.0;
+		size_t rejected = 0;
+		size_t differing = 0;
+	};
+
+	measurement measure( convert_fn const & convert, std::vector<std::string> const & inputs,
+	                     std::vector<std::string> const & expected, size_t repeats ) {
+		measurement result;
+		std::string out;
+		for( size_t n = 0; n < inputs.size( ); ++n ) {
+			if( !convert( inputs[n], out ) ) {
+				++result.rejected;
+			} else if( out != expected[n] ) {
+				++result.differing;
+			}
+		}
+		auto const start = std::chrono::steady_clock::now( );
+		for( size_t r = 0; r < repeats; ++r ) {
+			for( auto const & input : inputs ) {
+				convert( input, out );
+			}
+		}
+		std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now( ) - start;
+		result.ns_per_name = elapsed.count( ) / static_cast<double>( repeats * inputs.size( ) );
+		return result;
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	auto const corpus = argc > 1 ? load_corpus( argv[1] ) : default_corpus( );
+	std::map<std::string, std::vector<std::string>> groups;
+	for( auto const & host : corpus ) {
+		groups[classify( host )].push_back( host );
+	}
+	auto engines = make_engines( );
+	size_t const repeats = 5;
+
+	for( auto const & group : groups ) {
+		// Our results are the reference the others are compared with
+		std::vector<std::string> unicode;
+		std::vector<std::string> ace;
+		for( auto const & host : group.second ) {
+			try {
+				auto encoded = daw::to_puny_code( host );
+				unicode.push_back( daw::from_puny_code( encoded ) );
+				ace.push_back( std::move( encoded ) );
+			} catch( std::exception const & ) { }
+		}
+		if( ace.empty( ) ) {
+			continue;
+		}
+		std::cout << group.first << " (" << ace.size( ) << " names)\n";
+		std::cout << std::left << std::setw( 24 ) << "engine" << std::right << std::setw( 12 ) << "encode ns" << std::setw( 10 )
+		          << "relative" << std::setw( 12 ) << "decode ns" << std::setw( 10 ) << "relative" << std::setw( 10 )
+		          << "rejected" << std::setw( 10 ) << "differ" << '\n';
+		double reference_encode = 0.0;
+		double reference_decode = 0.0;
+		for( auto const & engine : engines ) {
+			engine.setup( );
+			auto const encode = measure( engine.encode, unicode, ace, repeats );
+			auto const decode = measure( engine.decode, ace, unicode, repeats );
+			if( reference_encode == 0.0 ) {
+				reference_encode = encode.ns_per_name;
+				reference_decode = decode.ns_per_name;
+			}
+			// Relative throughput, above 1 is faster than puny_coder
+			std::cout << std::left << std::setw( 24 ) << engine.name << std::right << std::fixed << std::setprecision( 1 )
+			          << std::setw( 12 ) << encode.ns_per_name << std::setprecision( 2 ) << std::setw( 10 )
+			          << reference_encode / encode.ns_per_name << std::setprecision( 1 ) << std::setw( 12 )
+			          << decode.ns_per_name << std::setprecision( 2 ) << std::setw( 10 )
+			          << reference_decode / decode.ns_per_name << std::setw( 10 ) << encode.rejected + decode.rejected
+			          << std::setw( 10 ) << encode.differing + decode.differing << '\n';
+		}
+		std::cout << '\n';
+	}
+	daw::set_label_cache_capacity( 4096 );
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Drives a running puny_coder_sidecar with pipelined requests from several connections and reports throughput
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "puny_coder_sidecar.h"
+
+namespace {
+	struct request_t {
+		daw::sidecar::operation op;
+		std::string host;
+	};
+
+	std::vector<request_t> default_corpus( ) {
+		using op = daw::sidecar::operation;
+		return { { op::to_puny_code, "example.com" },
+		         { op::to_puny_code, "Bücher.ch" },
+		         { op::to_puny_code, "www.ハンドボールサムズ.com" },
+		         { op::to_puny_code, "快乐.中国" },
+		         { op::to_puny_code, "🦄.com" },
+		         { op::from_puny_code, "xn--bcher-kva.ch" },
+		         { op::from_puny_code, "www.xn--vckk7bxa0eza9ezc9d.com" },
+		         { op::from_puny_code, "xn--fjqz24b.xn--fiqs8s" },
+		         { op::from_puny_code, "happy.cn" } };
+	}
+
+	// One hostname per line.  Lines that start with xn-- or contain an xn-- label are decoded, the rest encoded
+	std::vector<request_t> load_corpus( std::string const & path ) {
+		std::ifstream in( path );
+		if( !in ) {
+			throw std::runtime_error( "Could not open " + path );
+		}
+		std::vector<request_t> result;
+		std::string line;
+		while( std::getline( in, line ) ) {
+			if( line.empty( ) || line.size( ) > daw::sidecar::MAX_PAYLOAD_SIZE ) {
+				continue;
+			}
+			auto const is_ace = line.compare( 0, 4, "xn--" ) == 0 || line.find( ".xn--" ) != std::string::npos;
+			result.push_back(
+			  { is_ace ? daw::sidecar::operation::from_puny_code : daw::sidecar::operation::to_puny_code, line } );
+		}
+		return result;
+	}
+
+	int connect_to( std::string const & path ) {
+		auto const fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+		sockaddr_un addr{ };
+		addr.sun_family = AF_UNIX;
+		std::copy( path.begin( ), path.begin( ) + static_cast<std::ptrdiff_t>( std::min( path.size( ), sizeof( addr.sun_path ) - 1 ) ),
+		           addr.sun_path );
+		if( fd < 0 || connect( fd, reinterpret_cast<sockaddr *>( &addr ), sizeof( addr ) ) < 0 ) {
+			throw std::runtime_error( "Could not connect to " + path + ": " + std::strerror( errno ) );
+		}
+		return fd;
+	}
+
+	void write_all( int fd, std::string const & data ) {
+		size_t pos = 0;
+		while( pos < data.size( ) ) {
+			auto const count = write( fd, data.data( ) + pos, data.size( ) - pos );
+			if( count <= 0 ) {
+				throw std::runtime_error( "write failed" );
+			}
+			pos += static_cast<size_t>( count );
+		}
+	}
+
+	struct client_result {
+		size_t responses = 0;
+		size_t errors = 0;
+	};
+
+	// Keeps up to window requests outstanding on one connection
+	client_result run_client( std::string const & path, std::vector<request_t> const & corpus, size_t total, size_t window ) {
+		client_result result;
+		auto const fd = connect_to( path );
+		std::vector<unsigned char> input;
+		size_t sent = 0;
+		unsigned char buffer[64 * 1024];
+		while( result.responses < total ) {
+			std::string out;
+			while( sent < total && sent - result.responses < window ) {
+				auto const & req = corpus[sent % corpus.size( )];
+				unsigned char header[daw::sidecar::HEADER_SIZE];
+				daw::sidecar::write_header(
+				  { static_cast<uint32_t>( sent ), static_cast<uint8_t>( req.op ), static_cast<uint16_t>( req.host.size( ) ) },
+				  header );
+				out.append( reinterpret_cast<char const *>( header ), sizeof( header ) );
+				out.append( req.host );
+				++sent;
+			}
+			if( !out.empty( ) ) {
+				write_all( fd, out );
+			}
+			auto const count = read( fd, buffer, sizeof( buffer ) );
+			if( count <= 0 ) {
+				throw std::runtime_error( "Connection closed by sidecar" );
+			}
+			input.insert( input.end( ), buffer, buffer + count );
+			size_t pos = 0;
+			while( input.size( ) - pos >= daw::sidecar::HEADER_SIZE ) {
+				auto const header = daw::sidecar::read_header( input.data( ) + pos );
+				if( input.size( ) - pos - daw::sidecar::HEADER_SIZE < header.size ) {
+					break;
+				}
+				++result.responses;
+				if( header.code != static_cast<uint8_t>( daw::sidecar::status::ok ) ) {
+					++result.errors;
+				}
+				pos += daw::sidecar::HEADER_SIZE + header.size;
+			}
+			input.erase( input.begin( ), input.begin( ) + static_cast<std::ptrdiff_t>( pos ) );
+		}
+		close( fd );
+		return result;
+	}
+
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " [--socket PATH] [--corpus FILE] [--connections N] [--requests N] [--window N]\n";
+	}
+
+	// A whole decimal number of at least 1.  std::stoul alone accepts "12abc" and wraps "-1" around
+	size_t parse_count( std::string const & option, std::string const & value ) {
+		size_t end = 0;
+		unsigned long result = 0;
+		if( !value.empty( ) && std::isdigit( static_cast<unsigned char>( value[0] ) ) ) {
+			try {
+				result = std::stoul( value, &end );
+			} catch( std::out_of_range const & ) {
+				end = 0;
+			}
+		}
+		if( end == 0 || end != value.size( ) ) {
+			throw std::invalid_argument( option + " expects a number, not '" + value + "'" );
+		} else if( result == 0 ) {
+			throw std::invalid_argument( option + " must be at least 1" );
+		}
+		return result;
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	std::string socket_path = "/tmp/puny_coder.sock";
+	std::string corpus_path;
+	size_t connections = 4;
+	size_t requests = 1000000;
+	size_t window = 128;
+	try {
+		for( int n = 1; n < argc; n += 2 ) {
+			std::string const arg = argv[n];
+			if( n + 1 >= argc ) {
+				throw std::invalid_argument( arg + " expects a value" );
+			}
+			if( arg == "--socket" ) {
+				socket_path = argv[n + 1];
+			} else if( arg == "--corpus" ) {
+				corpus_path = argv[n + 1];
+			} else if( arg == "--connections" ) {
+				connections = parse_count( arg, argv[n + 1] );
+			} else if( arg == "--requests" ) {
+				requests = parse_count( arg, argv[n + 1] );
+			} else if( arg == "--window" ) {
+				window = parse_count( arg, argv[n + 1] );
+			} else {
+				throw std::invalid_argument( "Unknown option " + arg );
+			}
+		}
+		if( requests < connections ) {
+			throw std::invalid_argument( "--requests must be at least --connections" );
+		}
+	} catch( std::invalid_argument const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	try {
+		auto const corpus = corpus_path.empty( ) ? default_corpus( ) : load_corpus( corpus_path );
+		if( corpus.empty( ) ) {
+			throw std::runtime_error( "Corpus is empty" );
+		}
+		std::vector<client_result> results( connections );
+		std::vector<std::thread> threads;
+		auto const per_connection = requests / connections;
+		auto const start = std::chrono::steady_clock::now( );
+		for( size_t n = 0; n < connections; ++n ) {
+			threads.emplace_back( [&, n]( ) {
+				try {
+					results[n] = run_client( socket_path, corpus, per_connection, window );
+				} catch( std::exception const & ex ) {
+					std::cerr << ex.what( ) << '\n';
+				}
+			} );
+		}
+		for( auto & t : threads ) {
+			t.join( );
+		}
+		std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now( ) - start;
+		size_t responses = 0;
+		size_t errors = 0;
+		for( auto const & r : results ) {
+			responses += r.responses;
+			errors += r.errors;
+		}
+		std::cout << responses << " responses (" << errors << " errors) over " << connections << " connections in "
+		          << elapsed.count( ) << "s: " << static_cast<double>( responses ) / elapsed.count( ) << " req/s\n";
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
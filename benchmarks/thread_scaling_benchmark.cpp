@@ -0,0 +1,204 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Runs to_puny_code/from_puny_code from 1 to N threads over a shared corpus, checking every result, and reports per
+// thread throughput and scaling efficiency.  Each run is repeated with the label caches disabled and, as a control for
+// locale contention, with a std::ostringstream doing equivalent formatting work.  Efficiency well below that of the
+// uncached run points at the cache shard locks; efficiency of the stream control shows what the locale costs
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "puny_coder.h"
+
+namespace {
+	struct sample_t {
+		std::string unicode;
+		std::string ace;
+	};
+
+	std::vector<sample_t> default_corpus( ) {
+		return { { "example.com", "example.com" },
+		         { "bücher.ch", "xn--bcher-kva.ch" },
+		         { "happy快乐.cn", "xn--happy-9t1hs56h.cn" },
+		         { "快乐.中国", "xn--fjqz24b.xn--fiqs8s" },
+		         { "www.ハンドボールサムズ.com", "www.xn--vckk7bxa0eza9ezc9d.com" },
+		         { "🦄.com", "xn--3s9h.com" } };
+	}
+
+	// One Unicode hostname per line; the expected ACE form is computed up front.  Lines that do not convert are
+	// skipped and counted on stderr
+	std::vector<sample_t> load_corpus( std::string const & path ) {
+		std::ifstream in( path );
+		if( !in ) {
+			throw std::runtime_error( "Could not open " + path );
+		}
+		std::vector<sample_t> result;
+		std::string line;
+		size_t line_number = 0;
+		size_t skipped = 0;
+		while( std::getline( in, line ) ) {
+			++line_number;
+			if( line.empty( ) ) {
+				continue;
+			}
+			try {
+				auto ace = daw::to_puny_code( line );
+				result.push_back( { daw::from_puny_code( ace ), std::move( ace ) } );
+			} catch( std::exception const & ex ) {
+				std::cerr << path << ':' << line_number << ": skipped, " << ex.what( ) << '\n';
+				++skipped;
+			}
+		}
+		if( skipped > 0 ) {
+			std::cerr << "Skipped " << skipped << " lines that do not convert\n";
+		}
+		return result;
+	}
+
+	enum class workload { convert, stream_control };
+
+	struct run_result {
+		std::vector<double> per_thread; // operations per second
+		size_t mismatches = 0;
+	};
+
+	run_result run( std::vector<sample_t> const & corpus, size_t thread_count, workload work, size_t iterations ) {
+		run_result result;
+		result.per_thread.resize( thread_count );
+		std::atomic<size_t> mismatches{ 0 };
+		std::atomic<size_t> ready{ 0 };
+		std::atomic<bool> go{ false };
+		std::vector<std::thread> threads;
+		for( size_t t = 0; t < thread_count; ++t ) {
+			threads.emplace_back( [&, t]( ) {
+				++ready;
+				while( !go.load( ) ) {
+					std::this_thread::yield( );
+				}
+				size_t local_mismatches = 0;
+				size_t ops = 0;
+				auto const start = std::chrono::steady_clock::now( );
+				for( size_t n = 0; n < iterations; ++n ) {
+					// Offset each thread so they do not walk the corpus in lock step
+					auto const & sample = corpus[( n + t * 7 ) % corpus.size( )];
+					if( work == workload::convert ) {
+						local_mismatches += daw::to_puny_code( sample.unicode ) != sample.ace ? 1 : 0;
+						local_mismatches += daw::from_puny_code( sample.ace ) != sample.unicode ? 1 : 0;
+					} else {
+						std::ostringstream ss;
+						ss << sample.unicode << '.' << sample.ace;
+						local_mismatches += ss.str( ).size( ) != sample.unicode.size( ) + sample.ace.size( ) + 1 ? 1 : 0;
+					}
+					ops += 2;
+				}
+				std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now( ) - start;
+				result.per_thread[t] = static_cast<double>( ops ) / elapsed.count( );
+				mismatches += local_mismatches;
+			} );
+		}
+		while( ready.load( ) != thread_count ) {
+			std::this_thread::yield( );
+		}
+		go = true;
+		for( auto & th : threads ) {
+			th.join( );
+		}
+		result.mismatches = mismatches.load( );
+		return result;
+	}
+
+	bool report( char const * name, std::vector<sample_t> const & corpus, size_t max_threads, workload work,
+	             size_t iterations ) {
+		std::cout << name << '\n';
+		std::cout << std::setw( 8 ) << "threads" << std::setw( 16 ) << "total ops/s" << std::setw( 16 ) << "min/thread"
+		          << std::setw( 16 ) << "max/thread" << std::setw( 12 ) << "efficiency" << '\n';
+		double single = 0.0;
+		bool ok = true;
+		for( size_t threads = 1; threads <= max_threads; threads = threads < max_threads ? std::min( threads * 2, max_threads ) : threads + 1 ) {
+			auto const r = run( corpus, threads, work, iterations );
+			double total = 0.0;
+			for( auto v : r.per_thread ) {
+				total += v;
+			}
+			if( threads == 1 ) {
+				single = total;
+			}
+			auto const mm = std::minmax_element( r.per_thread.begin( ), r.per_thread.end( ) );
+			std::cout << std::setw( 8 ) << threads << std::setw( 16 ) << std::fixed << std::setprecision( 0 ) << total
+			          << std::setw( 16 ) << *mm.first << std::setw( 16 ) << *mm.second << std::setw( 11 )
+			          << std::setprecision( 1 ) << 100.0 * total / ( single * static_cast<double>( threads ) ) << "%\n";
+			if( r.mismatches != 0 ) {
+				std::cout << "  " << r.mismatches << " incorrect results\n";
+				ok = false;
+			}
+		}
+		std::cout << '\n';
+		return ok;
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	size_t max_threads = std::max( 1u, std::thread::hardware_concurrency( ) );
+	size_t iterations = 200000;
+	std::string corpus_path;
+	for( int n = 1; n + 1 < argc; n += 2 ) {
+		std::string const arg = argv[n];
+		if( arg == "--threads" ) {
+			max_threads = std::stoul( argv[n + 1] );
+		} else if( arg == "--iterations" ) {
+			iterations = std::stoul( argv[n + 1] );
+		} else if( arg == "--corpus" ) {
+			corpus_path = argv[n + 1];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--threads N] [--iterations N] [--corpus FILE]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::vector<sample_t> corpus;
+	try {
+		corpus = corpus_path.empty( ) ? default_corpus( ) : load_corpus( corpus_path );
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	if( corpus.empty( ) ) {
+		std::cerr << "The corpus has no hostnames\n";
+		return EXIT_FAILURE;
+	}
+	bool ok = report( "to_puny_code + from_puny_code, label caches on", corpus, max_threads, workload::convert, iterations );
+	daw::set_label_cache_capacity( 0 );
+	ok = report( "to_puny_code + from_puny_code, label caches off", corpus, max_threads, workload::convert, iterations ) && ok;
+	ok = report( "std::ostringstream control", corpus, max_threads, workload::stream_control, iterations ) && ok;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -23,10 +23,85 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <daw/daw_string_view.h>
 
 namespace daw {
+	// Thread safety: every function here may be called concurrently from any number of threads.  The conversions keep
+	// no state between calls other than the label caches, which are sharded and mutex protected; they do not use
+	// iostreams or locales.  Changing the cache capacity while conversions run is safe but drops the cached labels
 	std::string to_puny_code( daw::string_view input );
 	std::string from_puny_code( daw::string_view input );
+
+	// The same conversions written to a caller's buffer without allocating.  They return the size of the result; when
+	// that is larger than capacity only the first capacity bytes were written and the call can be repeated with a
+	// larger buffer
+	size_t to_puny_code( daw::string_view input, char * out, size_t capacity );
+	size_t from_puny_code( daw::string_view input, char * out, size_t capacity );
+
+	// Encodes many independent labels (not dotted hostnames) at once, giving the same result as to_puny_code on each.
+	// Non-ASCII labels are transposed into groups of 8 and encoded in lock step, one vector lane per label
+	std::vector<std::string> encode_labels( std::vector<daw::string_view> const & labels );
+
+	// Decodes many independent labels at once, giving the same result as from_puny_code on each.  The digits of 8
+	// xn-- labels are parsed in lock step and only the insertions are done per label
+	std::vector<std::string> decode_labels( std::vector<daw::string_view> const & labels );
+
+	struct label_cache_stats {
+		size_t hits;
+		size_t misses;
+		size_t admitted;
+		size_t rejected;
+		size_t capacity;
+	};
+
+	// Labels are memoized in bounded per direction tables.  A capacity of 0 disables them
+	void set_label_cache_capacity( size_t entries );
+	void clear_label_cache( );
+	label_cache_stats get_encode_label_cache_stats( );
+	label_cache_stats get_decode_label_cache_stats( );
+
+	enum class ace_error {
+		none,
+		invalid_length,
+		missing_prefix,
+		invalid_case,
+		invalid_character,
+		misplaced_delimiter,
+		no_encoded_code_points,
+		truncated_integer,
+		overflow,
+		encoded_basic_code_point,
+		invalid_code_point,
+		encoded_label_separator
+	};
+
+	char const * to_string( ace_error err ) noexcept;
+
+	// Checks that an xn-- label decodes and that to_puny_code would produce exactly the same bytes for the result, so a
+	// label that decodes to a UTS #46 full stop is an error as to_puny_code would split it there.  Nothing is allocated
+	ace_error validate_ace( daw::string_view label ) noexcept;
+
+	enum class hostname_class { ascii_ldh, contains_ace, contains_non_ascii, ipv4_literal, ipv6_literal, invalid };
+
+	struct hostname_classification {
+		static constexpr size_t const MAX_LABELS = 128;
+
+		hostname_class type;
+		size_t label_count;
+		std::array<uint16_t, MAX_LABELS> label_offsets;
+		std::array<uint16_t, MAX_LABELS> label_sizes;
+
+		daw::string_view label( daw::string_view host, size_t n ) const noexcept {
+			return daw::string_view{ host.data( ) + label_offsets[n], label_sizes[n] };
+		}
+	};
+
+	// Decides which conversion, if any, a hostname needs without converting it.  A single trailing root dot is
+	// accepted and not reported as a label
+	hostname_classification classify_hostname( daw::string_view host ) noexcept;
 }
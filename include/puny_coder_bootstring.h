@@ -0,0 +1,529 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// The Bootstring parameters of RFC 3492 section 5.  Another scheme supplies the same members: the constants, a
+	// delimiter, which code points are basic (all below INITIAL_N, anything else must be at least INITIAL_N), which
+	// code points a decoder may produce and a digit alphabet of BASE characters that does not contain the delimiter.
+	// decode_digit returns BASE for anything that is not a digit
+	struct punycode_parameters {
+		static constexpr uint32_t const BASE = 36;
+		static constexpr uint32_t const TMIN = 1;
+		static constexpr uint32_t const TMAX = 26;
+		static constexpr uint32_t const SKEW = 38;
+		static constexpr uint32_t const DAMP = 700;
+		static constexpr uint32_t const INITIAL_BIAS = 72;
+		static constexpr uint32_t const INITIAL_N = 128;
+		static constexpr char const DELIMITER = '-';
+
+		static constexpr bool is_basic( uint32_t cp ) noexcept {
+			return cp < 0x80;
+		}
+
+		// Unicode scalar values, so the result can be written as UTF-8
+		static constexpr bool is_valid_code_point( uint32_t cp ) noexcept {
+			return cp <= 0x10FFFF && ( cp < 0xD800 || cp > 0xDFFF );
+		}
+
+		static constexpr char encode_digit( uint32_t d ) noexcept {
+			return static_cast<char>( d < 26 ? d + 'a' : d - 26 + '0' );
+		}
+
+		static constexpr uint32_t decode_digit( uint32_t c ) noexcept {
+			if( c >= 'a' && c <= 'z' ) {
+				return c - 'a';
+			} else if( c >= 'A' && c <= 'Z' ) {
+				return c - 'A';
+			} else if( c >= '0' && c <= '9' ) {
+				return c - '0' + 26;
+			}
+			return BASE;
+		}
+	};
+
+	// Bootstring encoding and decoding of code point sequences, without the ACE prefix or any label handling.  The
+	// parameters are compile time constants so each instantiation is folded as if written by hand for them
+	template<typename Params>
+	class basic_bootstring {
+		static constexpr uint32_t const BASE = Params::BASE;
+		static constexpr uint32_t const TMIN = Params::TMIN;
+		static constexpr uint32_t const TMAX = Params::TMAX;
+		static constexpr uint32_t const INITIAL_N = Params::INITIAL_N;
+		static constexpr uint32_t const INITIAL_BIAS = Params::INITIAL_BIAS;
+
+		static_assert( TMIN <= TMAX && TMAX < BASE, "Bootstring requires 0 <= tmin <= tmax <= base - 1" );
+		static_assert( Params::SKEW >= 1 && Params::DAMP >= 2, "Bootstring requires skew >= 1 and damp >= 2" );
+		static_assert( INITIAL_BIAS % BASE <= BASE - TMIN, "Bootstring requires initial_bias mod base <= base - tmin" );
+
+		// A script block sized window, the code points present are found by walking a bitmap
+		static constexpr uint32_t const BLOCK_SIZE = 256;
+
+		static constexpr uint32_t code_unit( char c ) noexcept {
+			return static_cast<unsigned char>( c );
+		}
+
+		template<typename T>
+		static constexpr uint32_t code_unit( T c ) noexcept {
+			return static_cast<uint32_t>( c );
+		}
+
+		// Runs the delta loop, next_code_point( ) yields the distinct non-basic code points in ascending order
+		template<typename Range, typename Output, typename NextCodePoint>
+		static void encode_deltas( Range const & input, size_t len, size_t b, Output & output, NextCodePoint next_code_point ) {
+			auto h = b;
+			auto n = INITIAL_N;
+			auto bias = INITIAL_BIAS;
+			uint32_t delta = 0;
+
+			for( ; h < len; ++n, ++delta ) {
+				auto m = next_code_point( );
+
+				delta += (m - n) * static_cast<uint32_t>(h + 1);
+				n = m;
+
+				for( auto c : input ) {
+					if( c < n && ++delta == 0 ) {
+						throw std::runtime_error( "delta overflow" );
+					} else if( c == n ) {
+						encode_int( bias, delta, output );
+						bias = adapt( delta, static_cast<uint32_t>( h + 1 ), b == h );
+						delta = 0;
+						++h;
+					}
+				}
+			}
+		}
+
+		// Only one distinct non-basic code point m.  Everything before it is basic, so the first delta is
+		// (m - n)*(b + 1) plus its position and each later one is the count of basic code points since the last
+		template<typename Range, typename Output>
+		static void encode_single_code_point( Range const & input, size_t b, uint32_t m, Output & output ) {
+			auto h = b;
+			auto bias = INITIAL_BIAS;
+			uint32_t delta = (m - INITIAL_N) * static_cast<uint32_t>(b + 1);
+			uint64_t basic_run = 0;
+			for( auto c : input ) {
+				if( c != m ) {
+					++basic_run;
+					continue;
+				}
+				if( static_cast<uint64_t>( delta ) + basic_run > std::numeric_limits<uint32_t>::max( ) ) {
+					throw std::runtime_error( "delta overflow" );
+				}
+				delta += static_cast<uint32_t>( basic_run );
+				encode_int( bias, delta, output );
+				bias = adapt( delta, static_cast<uint32_t>( h + 1 ), b == h );
+				delta = 0;
+				basic_run = 0;
+				++h;
+			}
+		}
+
+	public:
+		using parameters = Params;
+
+		// Whether a decoder may output n, as decided by the parameters
+		static constexpr bool is_valid_code_point( uint32_t n ) noexcept {
+			return Params::is_valid_code_point( n );
+		}
+
+		static constexpr uint32_t adapt( uint32_t delta, uint32_t n_points, bool is_first ) noexcept {
+			// scale back, then increase delta
+			if( is_first ) {
+				delta /= Params::DAMP;
+			} else {
+				delta /= 2;
+			}
+			delta += delta / n_points;
+
+			uint32_t k = 0;
+			for( ; delta > ((BASE - TMIN) * TMAX)/2; k += BASE ) {
+				delta /= BASE - TMIN;
+			}
+			return k + ((BASE - TMIN + 1) * delta) / (delta + Params::SKEW);
+		}
+
+		static constexpr uint32_t threshold( uint32_t k, uint32_t bias ) noexcept {
+			if( k <= bias + TMIN ) {
+				return TMIN;
+			} else if( k >= bias + TMAX ) {
+				return TMAX;
+			}
+			return k - bias;
+		}
+
+		// Appends the variable length integer for delta to output, anything with push_back( char )
+		template<typename Output>
+		static void encode_int( uint32_t bias, uint32_t delta, Output & output ) {
+			auto q = delta;
+			for( auto k = BASE; ; k += BASE ) {
+				auto const t = threshold( k, bias );
+				if( q < t ) {
+					output.push_back( Params::encode_digit( q ) );
+					return;
+				}
+				output.push_back( Params::encode_digit( t + (q - t) % (BASE - t) ) );
+				q = (q - t)/(BASE - t);
+			}
+		}
+
+		// Encodes the code points of input, which is iterated several times, to output, anything with push_back( char ).
+		// Basic code points are written through map_basic, which returns a char.  Nothing is allocated
+		template<typename Range, typename Output, typename MapBasic>
+		static void encode( Range const & input, Output & output, MapBasic map_basic ) {
+			size_t len = 0;
+			size_t b = 0;
+			uint32_t lowest = std::numeric_limits<uint32_t>::max( );
+			uint32_t highest = 0;
+			for( auto c : input ) {
+				++len;
+				if( Params::is_basic( c ) ) {
+					++b;
+				} else {
+					lowest = std::min<uint32_t>( lowest, c );
+					highest = std::max<uint32_t>( highest, c );
+				}
+			}
+			if( b < len && lowest < INITIAL_N ) {
+				throw std::runtime_error( "Non-basic code point below the initial code point" );
+			}
+
+			for( auto c : input ) {
+				if( Params::is_basic( c ) ) {
+					output.push_back( map_basic( c ) );
+				}
+			}
+			if( b > 0 ) {
+				output.push_back( Params::DELIMITER );
+			}
+
+			if( b == len ) {
+				return;
+			} else if( lowest == highest ) {
+				encode_single_code_point( input, b, lowest, output );
+			} else if( highest - lowest < BLOCK_SIZE ) {
+				std::bitset<BLOCK_SIZE> present;
+				for( auto c : input ) {
+					if( !Params::is_basic( c ) ) {
+						present.set( c - lowest );
+					}
+				}
+				uint32_t offset = 0;
+				encode_deltas( input, len, b, output, [&]( ) {
+					while( !present[offset] ) {
+						++offset;
+					}
+					return lowest + offset++;
+				} );
+			} else {
+				// Each pass finds the smallest code point above the last one
+				uint32_t previous = INITIAL_N - 1;
+				encode_deltas( input, len, b, output, [&]( ) {
+					auto m = std::numeric_limits<uint32_t>::max( );
+					for( auto c : input ) {
+						if( c > previous && c < m ) {
+							m = c;
+						}
+					}
+					return previous = m;
+				} );
+			}
+		}
+
+		template<typename Range, typename Output>
+		static void encode( Range const & input, Output & output ) {
+			encode( input, output, []( uint32_t c ) { return static_cast<char>( c ); } );
+		}
+
+		static std::string encode( std::u32string const & input ) {
+			std::string result;
+			encode( input, result );
+			return result;
+		}
+
+		// Writes only what encode writes after the basic code points and delimiter, for callers that keep track of the
+		// code points between calls.  input holds b basic code points and [first, last) are its distinct non-basic
+		// code points in ascending order
+		template<typename Range, typename Iterator, typename Output>
+		static void encode_delta_section( Range const & input, size_t b, Iterator first, Iterator last, Output & output ) {
+			if( first == last ) {
+				return;
+			} else if( *first < INITIAL_N ) {
+				throw std::runtime_error( "Non-basic code point below the initial code point" );
+			} else if( std::next( first ) == last ) {
+				encode_single_code_point( input, b, *first, output );
+				return;
+			}
+			auto const len = static_cast<size_t>( std::distance( std::begin( input ), std::end( input ) ) );
+			encode_deltas( input, len, b, output, [&first]( ) {
+				return *first++;
+			} );
+		}
+
+		// Decodes the characters in [first, last) into at most capacity code points at out and returns how many there
+		// are.  Throws on invalid digits, truncated or overflowing integers and output larger than capacity.  No
+		// output is ever longer than the input
+		template<typename Iterator>
+		static size_t decode( Iterator first, Iterator last, uint32_t * out, size_t capacity ) {
+			// b is one past the last delimiter, the basic code points precede it
+			auto b = last;
+			while( b != first && code_unit( *(b - 1) ) != code_unit( Params::DELIMITER ) ) {
+				--b;
+			}
+			size_t size = 0;
+			if( b != first ) {
+				for( auto it = first; it != b - 1; ++it ) {
+					if( size == capacity ) {
+						throw std::runtime_error( "Decoded output is too large" );
+					}
+					out[size++] = code_unit( *it );
+				}
+			}
+
+			constexpr uint32_t const max_value = std::numeric_limits<uint32_t>::max( );
+			auto n = INITIAL_N;
+			auto bias = INITIAL_BIAS;
+			uint32_t i = 0;
+			for( auto it = b; it != last; ++i ) {
+				auto const original_i = i;
+				uint32_t w = 1;
+				for( auto k = BASE; ; k += BASE ) {
+					if( it == last ) {
+						throw std::runtime_error( "Unexpected character provided" );
+					}
+					auto const d = Params::decode_digit( code_unit( *it++ ) );
+					if( d >= BASE ) {
+						throw std::runtime_error( "Unexpected character provided" );
+					}
+					if( d > (max_value - i) / w ) {
+						throw std::runtime_error( "delta overflow" );
+					}
+					i += d * w;
+					auto const t = threshold( k, bias );
+					if( d < t ) {
+						break;
+					}
+					if( w > max_value / (BASE - t) ) {
+						throw std::runtime_error( "delta overflow" );
+					}
+					w *= BASE - t;
+				}
+				auto const x = static_cast<uint32_t>( size + 1 );
+				bias = adapt( i - original_i, x, 0 == original_i );
+				if( i / x > max_value - n ) {
+					throw std::runtime_error( "delta overflow" );
+				}
+				n += i / x;
+				i %= x;
+				if( !is_valid_code_point( n ) ) {
+					throw std::runtime_error( "Decoded code point is out of range" );
+				}
+				if( size == capacity ) {
+					throw std::runtime_error( "Decoded output is too large" );
+				}
+				std::copy_backward( out + i, out + size, out + size + 1 );
+				out[i] = n;
+				++size;
+			}
+			return size;
+		}
+
+		static std::u32string decode( daw::string_view input ) {
+			std::vector<uint32_t> code_points( input.size( ) );
+			code_points.resize( decode( input.begin( ), input.end( ), code_points.data( ), code_points.size( ) ) );
+			return std::u32string( code_points.begin( ), code_points.end( ) );
+		}
+	};
+
+	using punycode = basic_bootstring<punycode_parameters>;
+
+	// Decodes a raw Bootstring payload, without an ACE prefix or label handling, pushed in chunks of any size.  n, bias,
+	// i, w and a partly read integer are carried from one chunk to the next so each character is decoded as it
+	// arrives and finish( ) has nothing left to do but hand over the result.  Only the last delimiter ends the basic
+	// code points, so the characters after the latest one are decoded as deltas until another delimiter shows they
+	// were basic, which undoes their insertions.  As a later, larger code point can still be inserted anywhere, no code
+	// point is final before the end of the input.  Memory is the decoded code points and the characters since the
+	// latest delimiter.  Gives the same result, or throws the same error, as basic_bootstring::decode on the whole
+	template<typename Params>
+	class basic_bootstring_decoder {
+		using bootstring = basic_bootstring<Params>;
+
+		static constexpr uint32_t const BASE = Params::BASE;
+
+		std::vector<uint32_t> m_output;
+		// The characters since the latest delimiter, or since the start before there is one
+		std::string m_pending;
+		// Where each of their insertions went, to undo them
+		std::vector<uint32_t> m_inserted;
+		bool m_has_delimiter;
+		// Why the pending characters cannot be the deltas, reported by finish( ) unless a delimiter follows them
+		char const * m_error;
+
+		uint32_t m_n;
+		uint32_t m_bias;
+		uint32_t m_i;
+		uint32_t m_original_i;
+		uint32_t m_w;
+		uint32_t m_k;
+		bool m_in_integer;
+
+		void reset_deltas( ) noexcept {
+			m_inserted.clear( );
+			m_error = nullptr;
+			m_n = Params::INITIAL_N;
+			m_bias = Params::INITIAL_BIAS;
+			m_i = 0;
+			m_original_i = 0;
+			m_w = 1;
+			m_k = BASE;
+			m_in_integer = false;
+		}
+
+		// The pending characters are basic code points after all
+		void delimiter( ) {
+			for( auto it = m_inserted.rbegin( ); it != m_inserted.rend( ); ++it ) {
+				m_output.erase( m_output.begin( ) + static_cast<std::ptrdiff_t>( *it ) );
+			}
+			if( m_has_delimiter ) {
+				m_output.push_back( static_cast<unsigned char>( Params::DELIMITER ) );
+			}
+			for( auto c : m_pending ) {
+				m_output.push_back( static_cast<unsigned char>( c ) );
+			}
+			m_pending.clear( );
+			m_has_delimiter = true;
+			reset_deltas( );
+		}
+
+		void delta_character( uint32_t c ) {
+			constexpr uint32_t const max_value = std::numeric_limits<uint32_t>::max( );
+			if( !m_in_integer ) {
+				m_original_i = m_i;
+				m_w = 1;
+				m_k = BASE;
+				m_in_integer = true;
+			}
+			auto const d = Params::decode_digit( c );
+			if( d >= BASE ) {
+				m_error = "Unexpected character provided";
+				return;
+			}
+			if( d > (max_value - m_i) / m_w ) {
+				m_error = "delta overflow";
+				return;
+			}
+			m_i += d * m_w;
+			auto const t = bootstring::threshold( m_k, m_bias );
+			if( d >= t ) {
+				if( m_w > max_value / (BASE - t) ) {
+					m_error = "delta overflow";
+					return;
+				}
+				m_w *= BASE - t;
+				m_k += BASE;
+				return;
+			}
+			m_in_integer = false;
+			auto const x = static_cast<uint32_t>( m_output.size( ) + 1 );
+			m_bias = bootstring::adapt( m_i - m_original_i, x, 0 == m_original_i );
+			if( m_i / x > max_value - m_n ) {
+				m_error = "delta overflow";
+				return;
+			}
+			m_n += m_i / x;
+			m_i %= x;
+			if( !bootstring::is_valid_code_point( m_n ) ) {
+				m_error = "Decoded code point is out of range";
+				return;
+			}
+			m_output.insert( m_output.begin( ) + static_cast<std::ptrdiff_t>( m_i ), m_n );
+			m_inserted.push_back( m_i );
+			++m_i;
+		}
+
+	public:
+		using parameters = Params;
+
+		basic_bootstring_decoder( ) : m_has_delimiter( false ) {
+			reset_deltas( );
+		}
+
+		void push( daw::string_view chunk ) {
+			for( auto c : chunk ) {
+				if( c == Params::DELIMITER ) {
+					delimiter( );
+					continue;
+				}
+				m_pending.push_back( c );
+				if( m_error == nullptr ) {
+					delta_character( static_cast<unsigned char>( c ) );
+				}
+			}
+		}
+
+		// The number of code points decoded so far, some of which a later delimiter may still undo
+		size_t size( ) const noexcept {
+			return m_output.size( );
+		}
+
+		// Ends the input, writes the code points to output, anything with push_back( uint32_t ), and readies the
+		// decoder for another payload.  Throws on invalid digits, a truncated integer or overflow
+		template<typename Output>
+		void finish( Output & output ) {
+			if( m_error == nullptr && m_in_integer ) {
+				m_error = "Unexpected character provided";
+			}
+			if( m_error != nullptr ) {
+				auto const error = m_error;
+				reset( );
+				throw std::runtime_error( error );
+			}
+			for( auto cp : m_output ) {
+				output.push_back( cp );
+			}
+			reset( );
+		}
+
+		void reset( ) noexcept {
+			m_output.clear( );
+			m_pending.clear( );
+			m_has_delimiter = false;
+			reset_deltas( );
+		}
+	};
+
+	using punycode_decoder = basic_bootstring_decoder<punycode_parameters>;
+}    // namespace daw
@@ -0,0 +1,143 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// Immutable, memory mapped set of ACE hostnames kept in DNS canonical order, labels compared from the right, so
+	// that every zone is one contiguous run.  Names are front coded against their predecessor in blocks of
+	// BLOCK_SIZE and the first name of each block is stored whole as a restart point for binary search.  Names are
+	// addressed by their rank in that order.  Decoding is bounds checked, so a corrupt file ends iteration early and
+	// gives misses rather than reads outside the mapping
+	class hostname_dictionary {
+		struct impl;
+
+	public:
+		static constexpr size_t const BLOCK_SIZE = 32;
+		static constexpr size_t const MAX_NAME_SIZE = 255;
+
+		// Decodes one name per step; the view it yields is valid until the iterator is incremented or destroyed
+		class const_iterator {
+			impl const * m_impl;
+			size_t m_rank;
+			char const * m_next;
+			uint8_t m_key_size;
+			uint8_t m_name_size;
+			std::array<char, MAX_NAME_SIZE> m_key;
+			std::array<char, MAX_NAME_SIZE> m_name;
+
+			// False when the file is corrupt at this rank
+			bool load( ) noexcept;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = daw::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = daw::string_view const *;
+			using reference = daw::string_view;
+
+			const_iterator( impl const * i, size_t rank ) noexcept;
+
+			daw::string_view operator*( ) const noexcept {
+				return daw::string_view{ m_name.data( ), m_name_size };
+			}
+
+			size_t rank( ) const noexcept {
+				return m_rank;
+			}
+
+			const_iterator & operator++( );
+
+			const_iterator operator++( int ) {
+				auto result = *this;
+				++( *this );
+				return result;
+			}
+
+			friend bool operator==( const_iterator const & lhs, const_iterator const & rhs ) noexcept {
+				return lhs.m_rank == rhs.m_rank;
+			}
+
+			friend bool operator!=( const_iterator const & lhs, const_iterator const & rhs ) noexcept {
+				return lhs.m_rank != rhs.m_rank;
+			}
+		};
+
+	private:
+		std::shared_ptr<impl const> m_impl;
+
+		explicit hostname_dictionary( std::shared_ptr<impl const> i ) noexcept;
+
+	public:
+		static hostname_dictionary open( std::string const & path );
+
+		// Checks the payload checksum.  This reads the whole file
+		bool verify( ) const;
+		size_t size( ) const noexcept;
+		size_t size_bytes( ) const noexcept;
+
+		// The name of the given rank, throws std::out_of_range past the end and std::runtime_error if the file is
+		// corrupt there
+		std::string at( size_t rank ) const;
+
+		// Rank of an ACE hostname, or size( ) when it is not present.  No conversion is done
+		size_t rank( daw::string_view ace ) const noexcept;
+
+		// Looks up any spelling of a hostname by converting it with to_puny_code first
+		bool find( daw::string_view hostname, size_t & rank ) const;
+		bool contains( daw::string_view hostname ) const;
+
+		const_iterator begin( ) const noexcept;
+		const_iterator end( ) const noexcept;
+
+		// The names at or below zone, e.g. example.com and www.example.com for "example.com".  zone is converted
+		// with to_puny_code and an empty zone yields everything
+		std::pair<const_iterator, const_iterator> suffix_range( daw::string_view zone ) const;
+
+		// Calls f( name ) for every name beginning with prefix.  Names sharing a prefix are not adjacent in
+		// canonical order, so this decodes the whole dictionary
+		template<typename Function>
+		void for_each_prefix( daw::string_view prefix, Function f ) const {
+			for( auto const name : *this ) {
+				if( name.size( ) >= prefix.size( ) && std::equal( prefix.begin( ), prefix.end( ), name.begin( ) ) ) {
+					f( name );
+				}
+			}
+		}
+	};
+
+	// Converts each hostname with to_puny_code and writes the distinct results.  A trailing root dot is dropped; names
+	// that cannot be converted, are longer than MAX_NAME_SIZE or have empty labels are skipped
+	void write_hostname_dictionary( std::vector<std::string> const & hostnames, std::string const & path );
+}    // namespace daw
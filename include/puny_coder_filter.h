@@ -0,0 +1,63 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// Xor filter (8 bit fingerprints, ~9.8 bits per key, ~0.4% false positives) over the ACE forms of a set of
+	// hostnames.  A negative answer is definite, so it can reject hostnames before any conversion or index probe.
+	// ACE lookups are case insensitive
+	class idn_filter {
+		std::shared_ptr<void const> m_storage;
+		uint64_t m_seed = 0;
+		uint64_t m_block_length = 0;
+		uint64_t m_key_count = 0;
+		uint8_t const * m_fingerprints = nullptr;
+
+	public:
+		// Hostnames may be given in Unicode or ACE form
+		static idn_filter build( std::vector<std::string> const & hostnames );
+		// Maps a file written by save
+		static idn_filter open( std::string const & path );
+		void save( std::string const & path ) const;
+
+		size_t size( ) const noexcept {
+			return static_cast<size_t>( m_key_count );
+		}
+
+		size_t size_in_bytes( ) const noexcept {
+			return static_cast<size_t>( 3 * m_block_length );
+		}
+
+		bool may_contain_ace( daw::string_view ace ) const noexcept;
+		// Converts non-ASCII input with to_puny_code first
+		bool may_contain( daw::string_view hostname ) const;
+	};
+}    // namespace daw
@@ -0,0 +1,192 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	namespace impl {
+		// FNV-1a
+		inline size_t hash_bytes( daw::string_view value ) noexcept {
+			uint64_t result = 14695981039346656037ULL;
+			for( auto c : value ) {
+				result ^= static_cast<unsigned char>( c );
+				result *= 1099511628211ULL;
+			}
+			return static_cast<size_t>( result );
+		}
+	}    // namespace impl
+
+	// A hostname held inline in 256 bytes, the 255 byte DNS maximum plus its size.  It never allocates and is trivially
+	// copyable, so it can be stored by value in large containers and queues
+	class hostname {
+	public:
+		static constexpr size_t const MAX_SIZE = 255;
+
+	private:
+		std::array<char, MAX_SIZE> m_data;
+		uint8_t m_size;
+
+	public:
+		constexpr hostname( ) noexcept : m_data{ }, m_size( 0 ) { }
+
+		explicit hostname( daw::string_view value ) : m_data{ }, m_size( 0 ) {
+			if( value.size( ) > MAX_SIZE ) {
+				throw std::runtime_error( "A hostname cannot be longer than 255 bytes" );
+			}
+			std::copy( value.begin( ), value.end( ), m_data.begin( ) );
+			m_size = static_cast<uint8_t>( value.size( ) );
+		}
+
+		// For filling in place; size must not be more than MAX_SIZE
+		char * data( ) noexcept {
+			return m_data.data( );
+		}
+
+		void resize( size_t size ) noexcept {
+			m_size = static_cast<uint8_t>( size < MAX_SIZE ? size : MAX_SIZE );
+		}
+
+		char const * data( ) const noexcept {
+			return m_data.data( );
+		}
+
+		size_t size( ) const noexcept {
+			return m_size;
+		}
+
+		bool empty( ) const noexcept {
+			return m_size == 0;
+		}
+
+		char const * begin( ) const noexcept {
+			return m_data.data( );
+		}
+
+		char const * end( ) const noexcept {
+			return m_data.data( ) + m_size;
+		}
+
+		daw::string_view view( ) const noexcept {
+			return daw::string_view{ m_data.data( ), m_size };
+		}
+
+		std::string to_string( ) const {
+			return std::string( m_data.data( ), m_size );
+		}
+
+		friend bool operator==( hostname const & lhs, hostname const & rhs ) noexcept {
+			return lhs.m_size == rhs.m_size && std::equal( lhs.begin( ), lhs.end( ), rhs.begin( ) );
+		}
+
+		friend bool operator!=( hostname const & lhs, hostname const & rhs ) noexcept {
+			return !( lhs == rhs );
+		}
+
+		friend bool operator<( hostname const & lhs, hostname const & rhs ) noexcept {
+			return std::lexicographical_compare( lhs.begin( ), lhs.end( ), rhs.begin( ), rhs.end( ) );
+		}
+	};
+
+	// The conversions of puny_coder.h producing a hostname without allocating.  They throw if the result is longer
+	// than 255 bytes, which a Unicode form can be even when its ACE form fits
+	hostname to_puny_code_hostname( daw::string_view input );
+	hostname from_puny_code_hostname( daw::string_view input );
+
+	// An immutable, reference counted hostname that is converted once and then passed around.  It holds the canonical
+	// ACE form (to_puny_code of what it was made from), its hash and label offsets.  The Unicode form is computed the
+	// first time it is asked for and kept.  Copies share the same object and may be used from any thread
+	class shared_hostname {
+		struct data_t {
+			std::string ace;
+			size_t hash;
+			std::vector<uint16_t> label_offsets;
+			mutable std::once_flag unicode_flag;
+			mutable std::string unicode;
+
+			explicit data_t( std::string ace_form );
+		};
+		std::shared_ptr<data_t const> m_data;
+
+	public:
+		// Accepts either form, throws as to_puny_code does
+		explicit shared_hostname( daw::string_view input );
+
+		daw::string_view ace( ) const noexcept {
+			return daw::string_view{ m_data->ace.data( ), m_data->ace.size( ) };
+		}
+
+		// Throws as from_puny_code does; a conversion that threw is tried again on the next call
+		daw::string_view unicode( ) const;
+
+		size_t hash( ) const noexcept {
+			return m_data->hash;
+		}
+
+		size_t label_count( ) const noexcept {
+			return m_data->label_offsets.size( );
+		}
+
+		// Label n of the ACE form, from the left
+		daw::string_view label( size_t n ) const noexcept;
+
+		friend bool operator==( shared_hostname const & lhs, shared_hostname const & rhs ) noexcept {
+			return lhs.m_data == rhs.m_data || ( lhs.m_data->hash == rhs.m_data->hash && lhs.m_data->ace == rhs.m_data->ace );
+		}
+
+		friend bool operator!=( shared_hostname const & lhs, shared_hostname const & rhs ) noexcept {
+			return !( lhs == rhs );
+		}
+
+		friend bool operator<( shared_hostname const & lhs, shared_hostname const & rhs ) noexcept {
+			return lhs.m_data->ace < rhs.m_data->ace;
+		}
+	};
+}    // namespace daw
+
+namespace std {
+	template<>
+	struct hash<daw::hostname> {
+		size_t operator( )( daw::hostname const & value ) const noexcept {
+			return daw::impl::hash_bytes( value.view( ) );
+		}
+	};
+
+	template<>
+	struct hash<daw::shared_hostname> {
+		size_t operator( )( daw::shared_hostname const & value ) const noexcept {
+			return value.hash( );
+		}
+	};
+}    // namespace std
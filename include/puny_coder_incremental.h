@@ -0,0 +1,95 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// Keeps to_puny_code( text( ) ) current while the text is edited a keystroke at a time.  Labels an edit did not
+	// touch keep their encoding.  For the last label it also keeps the code points, the lower cased basic code points
+	// and the distinct non-basic code points in order, so an edit at its end only updates those and writes the deltas
+	// again.  Edits never throw; ace( ) throws as to_puny_code does
+	class incremental_encoder {
+		struct label_t {
+			size_t first;
+			size_t size;
+			size_t separator;
+			size_t ace_first;
+			size_t ace_size;
+		};
+
+		std::string m_text;
+		std::string m_ace;
+		std::vector<label_t> m_labels;
+		// The leading labels whose encoding in m_ace is current
+		size_t m_encoded;
+		size_t m_labels_encoded;
+
+		// The last label as of the previous ace( ): where it starts, how many of its bytes are decoded into the state
+		// below and how many of those the edits since have left as they were
+		size_t m_state_first;
+		size_t m_state_decoded;
+		size_t m_state_valid;
+		std::vector<uint32_t> m_code_points;
+		std::string m_basic;
+		std::vector<uint32_t> m_distinct;
+		std::vector<uint32_t> m_counts;
+
+		void edited( size_t unchanged );
+		void split( size_t first );
+		void push_code_point( uint32_t cp );
+		void pop_code_point( );
+		void encode_last( label_t const & label );
+
+	public:
+		incremental_encoder( );
+		explicit incremental_encoder( daw::string_view text );
+
+		void append( daw::string_view text );
+
+		// Removes the last code point, or the last byte if that is not the end of a UTF-8 sequence
+		void pop_back( );
+
+		// Replaces the text; labels before the first changed byte keep their encoding
+		void assign( daw::string_view text );
+
+		void clear( );
+
+		daw::string_view text( ) const noexcept {
+			return daw::string_view{ m_text.data( ), m_text.size( ) };
+		}
+
+		// The same as to_puny_code( text( ) ), encoding only the labels changed since the last call
+		daw::string_view ace( );
+
+		// How many non-empty labels have been encoded, to see what the edits cost
+		size_t labels_encoded( ) const noexcept {
+			return m_labels_encoded;
+		}
+	};
+}    // namespace daw
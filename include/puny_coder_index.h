@@ -0,0 +1,60 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// Immutable, memory mapped table of precomputed conversions in both directions.  Opening only maps the file and
+	// checks its header; lookups bounds check every slot, so a corrupt file gives misses rather than reads outside the
+	// mapping.  Results point directly into the mapping.  The pages are shared by every process that maps the
+	// same file
+	class conversion_index {
+		struct impl;
+		std::shared_ptr<impl const> m_impl;
+
+		explicit conversion_index( std::shared_ptr<impl const> i ) noexcept;
+
+	public:
+		static conversion_index open( std::string const & path );
+
+		// Checks the payload checksum.  This reads the whole file
+		bool verify( ) const;
+		size_t size( ) const noexcept;
+
+		bool find_ace( daw::string_view unicode, daw::string_view & ace ) const noexcept;
+		bool find_unicode( daw::string_view ace, daw::string_view & unicode ) const noexcept;
+
+		// Consult the index and fall back to daw::to_puny_code/from_puny_code
+		std::string to_puny_code( daw::string_view input ) const;
+		std::string from_puny_code( daw::string_view input ) const;
+	};
+
+	// Converts each hostname and writes an index of the results.  Hostnames that need no conversion are skipped
+	void write_conversion_index( std::vector<std::string> const & hostnames, std::string const & path );
+}    // namespace daw
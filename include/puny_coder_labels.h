@@ -0,0 +1,135 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	// Size of the label separator starting at position of host: 1 for '.', 3 for the UTS #46 full stops U+3002,
+	// U+FF0E and U+FF61, otherwise 0
+	size_t label_separator_size( daw::string_view host, size_t position ) noexcept;
+
+	// Position of the next separator at or after first, or host.size( )
+	size_t find_label_separator( daw::string_view host, size_t first ) noexcept;
+
+	// Position just past the last separator that ends at or before last, or 0
+	size_t rfind_label_separator( daw::string_view host, size_t last ) noexcept;
+
+	// The labels of a hostname, found lazily in either direction without allocating.  Like splitting on the
+	// separators, n separators give n + 1 labels, some of which may be empty
+	class label_view {
+		daw::string_view m_host;
+
+	public:
+		class iterator {
+			daw::string_view m_host;
+			size_t m_first;
+			size_t m_last;
+
+			friend class label_view;
+
+			iterator( daw::string_view host, size_t first, size_t last ) noexcept : m_host( host ), m_first( first ), m_last( last ) { }
+
+			bool is_end( ) const noexcept {
+				return m_first > m_host.size( );
+			}
+
+		public:
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = daw::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = daw::string_view;
+
+			iterator( ) noexcept : m_host( ), m_first( 1 ), m_last( 1 ) { }
+
+			daw::string_view operator*( ) const noexcept {
+				return m_host.substr( m_first, m_last - m_first );
+			}
+
+			iterator & operator++( ) noexcept {
+				if( m_last == m_host.size( ) ) {
+					m_first = m_last = m_host.size( ) + 1;
+				} else {
+					m_first = m_last + label_separator_size( m_host, m_last );
+					m_last = find_label_separator( m_host, m_first );
+				}
+				return *this;
+			}
+
+			iterator operator++( int ) noexcept {
+				auto result = *this;
+				++( *this );
+				return result;
+			}
+
+			iterator & operator--( ) noexcept {
+				if( is_end( ) ) {
+					m_last = m_host.size( );
+				} else {
+					// The separator before this label ends at m_first
+					m_last = m_first - ( m_host[m_first - 1] == '.' ? 1 : 3 );
+				}
+				m_first = rfind_label_separator( m_host, m_last );
+				return *this;
+			}
+
+			iterator operator--( int ) noexcept {
+				auto result = *this;
+				--( *this );
+				return result;
+			}
+
+			friend bool operator==( iterator const & lhs, iterator const & rhs ) noexcept {
+				return lhs.m_first == rhs.m_first && lhs.m_host.data( ) == rhs.m_host.data( );
+			}
+
+			friend bool operator!=( iterator const & lhs, iterator const & rhs ) noexcept {
+				return !( lhs == rhs );
+			}
+		};
+
+		using reverse_iterator = std::reverse_iterator<iterator>;
+
+		explicit label_view( daw::string_view host ) noexcept : m_host( host ) { }
+
+		iterator begin( ) const noexcept {
+			return iterator( m_host, 0, find_label_separator( m_host, 0 ) );
+		}
+
+		iterator end( ) const noexcept {
+			return iterator( m_host, m_host.size( ) + 1, m_host.size( ) + 1 );
+		}
+
+		reverse_iterator rbegin( ) const noexcept {
+			return reverse_iterator( end( ) );
+		}
+
+		reverse_iterator rend( ) const noexcept {
+			return reverse_iterator( begin( ) );
+		}
+	};
+}    // namespace daw
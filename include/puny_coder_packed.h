@@ -0,0 +1,123 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <daw/daw_string_view.h>
+
+#include "puny_coder_hostname.h"
+
+namespace daw {
+	// ACE hostnames use 38 characters, so each is stored as a 6 bit code, most significant bits first, four to every
+	// three bytes.  The codes keep the order of the characters: 0 pads the last byte, then '-', '.', '0' - '9' and
+	// 'a' - 'z' are 1 - 38.  Packed forms therefore compare bytewise in the same order as the text
+	constexpr size_t packed_size( size_t characters ) noexcept {
+		return ( characters * 6 + 7 ) / 8;
+	}
+
+	// Packs an ACE hostname into out and returns packed_size( ace.size( ) ); when that is larger than capacity nothing
+	// was written.  Throws if ace has a character outside the 38, upper case included
+	size_t pack_hostname( daw::string_view ace, uint8_t * out, size_t capacity );
+
+	// Unpacks size bytes made by pack_hostname and returns the number of characters; when that is larger than capacity
+	// only the first capacity characters were written.  Throws if the bytes are not a packed hostname
+	size_t unpack_hostname( uint8_t const * packed, size_t size, char * out, size_t capacity );
+
+	// A packed hostname held inline like hostname: 193 bytes instead of 256, trivially copyable and compared and
+	// hashed without unpacking
+	class packed_hostname {
+	public:
+		static constexpr size_t const MAX_SIZE = 255;
+		static constexpr size_t const MAX_BYTES = packed_size( MAX_SIZE );
+
+	private:
+		std::array<uint8_t, MAX_BYTES> m_data;
+		uint8_t m_size;
+
+	public:
+		constexpr packed_hostname( ) noexcept : m_data{ }, m_size( 0 ) { }
+
+		// Throws as pack_hostname does or if ace is longer than MAX_SIZE
+		explicit packed_hostname( daw::string_view ace );
+
+		// Adopts bytes from pack_hostname, such as those read from the wire.  Throws if they are not a packed hostname
+		static packed_hostname from_bytes( uint8_t const * packed, size_t size );
+
+		uint8_t const * data( ) const noexcept {
+			return m_data.data( );
+		}
+
+		size_t size_bytes( ) const noexcept {
+			return packed_size( m_size );
+		}
+
+		// The number of characters
+		size_t size( ) const noexcept {
+			return m_size;
+		}
+
+		bool empty( ) const noexcept {
+			return m_size == 0;
+		}
+
+		std::string to_string( ) const;
+
+		hostname to_hostname( ) const;
+
+		friend bool operator==( packed_hostname const & lhs, packed_hostname const & rhs ) noexcept {
+			return lhs.m_size == rhs.m_size && std::equal( lhs.data( ), lhs.data( ) + lhs.size_bytes( ), rhs.data( ) );
+		}
+
+		friend bool operator!=( packed_hostname const & lhs, packed_hostname const & rhs ) noexcept {
+			return !( lhs == rhs );
+		}
+
+		// The same order as comparing the unpacked text
+		friend bool operator<( packed_hostname const & lhs, packed_hostname const & rhs ) noexcept {
+			return std::lexicographical_compare( lhs.data( ), lhs.data( ) + lhs.size_bytes( ), rhs.data( ), rhs.data( ) + rhs.size_bytes( ) );
+		}
+	};
+
+	// Converts to ACE as to_puny_code does and packs the result without allocating.  Throws as to_puny_code does, if the
+	// result is longer than 255 bytes or if it has a character that cannot be packed, such as '_'
+	packed_hostname to_puny_code_packed( daw::string_view input );
+
+	// Packs many ACE hostnames, 16 characters at a time with SSSE3 where available
+	std::vector<packed_hostname> pack_hostnames( std::vector<daw::string_view> const & aces );
+}    // namespace daw
+
+namespace std {
+	template<>
+	struct hash<daw::packed_hostname> {
+		size_t operator( )( daw::packed_hostname const & value ) const noexcept {
+			return daw::impl::hash_bytes( daw::string_view{ reinterpret_cast<char const *>( value.data( ) ), value.size_bytes( ) } );
+		}
+	};
+}    // namespace std
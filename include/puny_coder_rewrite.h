@@ -0,0 +1,48 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	enum class rewrite_direction {
+		to_unicode,    // xn-- hostnames are decoded
+		to_ace         // non-ASCII hostnames are encoded
+	};
+
+	struct rewrite_stats {
+		size_t found = 0;
+		size_t rewritten = 0;
+	};
+
+	// Appends text to output with the hostnames in it converted.  A hostname is a run of letters, digits, hyphens,
+	// dots and non-ASCII characters other than punctuation and spaces, such as quotes or U+00A0, without leading or
+	// trailing dots or hyphens, with labels of 1 to 63 bytes.  It is
+	// only rewritten if it has an xn-- label that validates (to_unicode) or is valid UTF-8 with more than one label
+	// (to_ace); anything else, including hostnames that fail to convert, is copied unchanged.  Text between
+	// candidates is skipped 16 bytes at a time
+	rewrite_stats rewrite_hostnames( daw::string_view text, rewrite_direction direction, std::string & output );
+}    // namespace daw
@@ -0,0 +1,67 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <daw/daw_string_view.h>
+
+namespace daw {
+	enum class conversion_direction : uint8_t { encode = 1, decode = 2 };
+
+	// Hostname conversion cache in a shared memory segment so that every process on a host shares one warm copy.  The
+	// table is open addressed with fixed size entries and each entry is guarded by its own sequence counter, so readers
+	// and writers never block.  A process that dies mid-write leaves its entry marked busy; readers skip it and writers
+	// reclaim it once its owner's pid is gone, or after 10s regardless.  Lookups and inserts are safe from any thread of any attached process
+	class shared_conversion_cache {
+		void * m_base = nullptr;
+		size_t m_size = 0;
+		int m_fd = -1;
+
+		shared_conversion_cache( void * base, size_t size, int fd ) noexcept;
+		void release( ) noexcept;
+
+	public:
+		// Creates or attaches to a named segment in /dev/shm.  All processes must agree on entry_count
+		static shared_conversion_cache open( std::string const & name, size_t entry_count );
+		// Creates an unnamed segment (memfd) that is shared with children created by fork( ) after this call
+		static shared_conversion_cache create_anonymous( size_t entry_count );
+		static void remove( std::string const & name );
+
+		shared_conversion_cache( shared_conversion_cache && other ) noexcept;
+		shared_conversion_cache & operator=( shared_conversion_cache && other ) noexcept;
+		shared_conversion_cache( shared_conversion_cache const & ) = delete;
+		shared_conversion_cache & operator=( shared_conversion_cache const & ) = delete;
+		~shared_conversion_cache( );
+
+		size_t entry_count( ) const noexcept;
+		bool find( conversion_direction direction, daw::string_view key, std::string & value ) const;
+		void insert( conversion_direction direction, daw::string_view key, daw::string_view value );
+
+		// Consult the cache and fall back to daw::to_puny_code/from_puny_code, caching the result
+		std::string to_puny_code( daw::string_view input );
+		std::string from_puny_code( daw::string_view input );
+	};
+}    // namespace daw
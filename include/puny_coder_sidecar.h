@@ -0,0 +1,66 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace daw {
+	namespace sidecar {
+		// Wire format shared by the sidecar daemon and its clients.  Every frame is an 8 byte little endian header
+		// followed by size bytes of payload.  Requests carry a hostname, responses echo the request id and carry either
+		// the converted hostname or an error message.  Responses on a connection may arrive out of order
+		enum class operation : uint8_t { to_puny_code = 0, from_puny_code = 1 };
+		enum class status : uint8_t { ok = 0, error = 1 };
+
+		constexpr size_t const HEADER_SIZE = 8;
+		constexpr size_t const MAX_PAYLOAD_SIZE = 0xFFFF;
+
+		struct frame_header {
+			uint32_t id;
+			uint8_t code; // operation for requests, status for responses
+			uint16_t size;
+		};
+
+		inline void write_header( frame_header const & header, unsigned char * out ) noexcept {
+			out[0] = static_cast<unsigned char>( header.id );
+			out[1] = static_cast<unsigned char>( header.id >> 8 );
+			out[2] = static_cast<unsigned char>( header.id >> 16 );
+			out[3] = static_cast<unsigned char>( header.id >> 24 );
+			out[4] = header.code;
+			out[5] = 0;
+			out[6] = static_cast<unsigned char>( header.size );
+			out[7] = static_cast<unsigned char>( header.size >> 8 );
+		}
+
+		inline frame_header read_header( unsigned char const * in ) noexcept {
+			frame_header result;
+			result.id = static_cast<uint32_t>( in[0] ) | static_cast<uint32_t>( in[1] ) << 8 |
+			            static_cast<uint32_t>( in[2] ) << 16 | static_cast<uint32_t>( in[3] ) << 24;
+			result.code = in[4];
+			result.size = static_cast<uint16_t>( in[6] | in[7] << 8 );
+			return result;
+		}
+	}    // namespace sidecar
+}    // namespace daw
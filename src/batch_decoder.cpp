@@ -0,0 +1,335 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_impl.h"
+
+namespace daw {
+	namespace {
+		using namespace daw::impl;
+
+		constexpr size_t const LANES = 8;
+		// A label is at most 63 characters so at most 59 follow the prefix.  Each code point of the output uses at
+		// least one of them, so neither the digits nor the output of a lane can pass 64
+		constexpr size_t const MAX_DIGITS = 64;
+		constexpr size_t const MAX_OUTPUT = 64;
+		// Marks positions past the end of a lane's digits
+		constexpr int32_t const NO_DIGIT = -1;
+		// Bounds that keep every intermediate below 2^31.  A valid label never gets near them, any lane that does
+		// is handed to the scalar decoder which gives the same result or exception as from_puny_code
+		constexpr int32_t const MAX_I = 1 << 29;
+		constexpr int32_t const MAX_W = 1 << 24;
+
+		// Up to LANES labels with the digits after their last delimiter transposed, so that the j'th digit of every
+		// label is one vector.  Each lane consumes exactly one digit per step.  Rather than moving code points on every
+		// insertion, a lane keeps them in the order they were decoded along with where each one currently is, and they
+		// are put in order once at the end
+		struct lane_group {
+			alignas( 32 ) std::array<std::array<int32_t, LANES>, MAX_DIGITS> digits;
+			alignas( 32 ) std::array<std::array<int8_t, MAX_OUTPUT>, LANES> position;
+			alignas( 32 ) std::array<int32_t, LANES> size;
+			std::array<std::array<uint32_t, MAX_OUTPUT>, LANES> code_points;
+			std::array<size_t, LANES> digit_count;
+			std::array<size_t, LANES> index;
+			size_t lane_count = 0;
+			size_t max_digits = 0;
+		};
+
+		// The digit value of every byte, or NO_DIGIT.  Letters and digits come in no predictable order, so this is a
+		// table rather than decode_digit's branches
+		std::array<int8_t, 256> const digit_values = []( ) {
+			std::array<int8_t, 256> result;
+			for( uint32_t c = 0; c < result.size( ); ++c ) {
+				auto const d = punycode_parameters::decode_digit( c );
+				result[c] = static_cast<int8_t>( d == constants::BASE ? NO_DIGIT : static_cast<int32_t>( d ) );
+			}
+			return result;
+		}( );
+
+		// Labels that decode_part would copy unchanged, or that would not fit a lane, are not loaded
+		bool is_simple( daw::string_view label ) noexcept {
+			if( label.empty( ) || label.size( ) > 63 ) {
+				return false;
+			}
+			return std::none_of( label.begin( ), label.end( ), []( char c ) {
+				return static_cast<unsigned char>( c ) >= 128 || c == '.';
+			} );
+		}
+
+		bool load_lane( lane_group & g, size_t lane, daw::string_view label ) {
+			auto const input = label.substr( constants::PREFIX.size( ) );
+			// b is one past the last delimiter, the basic code points precede it
+			auto b = input.size( );
+			while( b > 0 && input[b - 1] != constants::DELIMITER ) {
+				--b;
+			}
+			size_t size = 0;
+			for( ; size + 1 < b; ++size ) {
+				g.code_points[lane][size] = static_cast<unsigned char>( input[size] );
+				g.position[lane][size] = static_cast<int8_t>( size );
+			}
+			size_t count = 0;
+			for( ; b < input.size( ); ++b ) {
+				int32_t const d = digit_values[static_cast<unsigned char>( input[b] )];
+				if( d == NO_DIGIT ) {
+					return false;
+				}
+				g.digits[count++][lane] = d;
+			}
+			g.size[lane] = static_cast<int32_t>( size );
+			g.digit_count[lane] = count;
+			g.max_digits = std::max( g.max_digits, count );
+			return true;
+		}
+
+		// Every code point at or after position moves up by one
+		void insert( lane_group & g, size_t lane, size_t position, uint32_t code_point ) noexcept {
+			auto const added = static_cast<size_t>( g.size[lane]++ );
+			g.code_points[lane][added] = code_point;
+			auto const positions = g.position[lane].data( );
+#ifdef __AVX2__
+			// Entries past added are not in use yet, so all 64 are updated without branches
+			auto const before = _mm256_set1_epi8( static_cast<char>( position - 1 ) );
+			auto const value = _mm256_set1_epi8( static_cast<char>( position ) );
+			auto const target = _mm256_set1_epi8( static_cast<char>( added ) );
+			auto index = _mm256_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+			                               24, 25, 26, 27, 28, 29, 30, 31 );
+			for( size_t half = 0; half < MAX_OUTPUT; half += 32 ) {
+				auto const p = reinterpret_cast<__m256i *>( positions + half );
+				auto v = _mm256_load_si256( p );
+				v = _mm256_sub_epi8( v, _mm256_cmpgt_epi8( v, before ) );
+				_mm256_store_si256( p, _mm256_blendv_epi8( v, value, _mm256_cmpeq_epi8( index, target ) ) );
+				index = _mm256_add_epi8( index, _mm256_set1_epi8( 32 ) );
+			}
+#else
+			for( size_t n = 0; n < added; ++n ) {
+				positions[n] += positions[n] >= static_cast<int8_t>( position ) ? 1 : 0;
+			}
+			positions[added] = static_cast<int8_t>( position );
+#endif
+		}
+
+#ifdef __AVX2__
+		__m256i load( std::array<int32_t, LANES> const & values ) noexcept {
+			return _mm256_load_si256( reinterpret_cast<__m256i const *>( values.data( ) ) );
+		}
+
+		void store( std::array<int32_t, LANES> & values, __m256i v ) noexcept {
+			_mm256_store_si256( reinterpret_cast<__m256i *>( values.data( ) ), v );
+		}
+
+		uint32_t lane_mask( __m256i v ) noexcept {
+			return static_cast<uint32_t>( _mm256_movemask_ps( _mm256_castsi256_ps( v ) ) );
+		}
+
+		// Runs every lane through its digits, consuming digit j of every lane on step j: i += d*w, the threshold, and
+		// either w *= BASE - t or the end of the integer.  The decoder state stays in registers for the whole group,
+		// only the insertions are done per lane.  Returns a bit for each lane that must use the scalar decoder
+		uint32_t decode_lanes( lane_group & g ) noexcept {
+			auto const one = _mm256_set1_epi32( 1 );
+			auto const base = _mm256_set1_epi32( constants::BASE );
+			auto x = _mm256_add_epi32( load( g.size ), one );
+			auto i = _mm256_setzero_si256( );
+			auto original_i = i;
+			auto w = one;
+			auto k = base;
+			auto bias = _mm256_set1_epi32( constants::INITIAL_BIAS );
+			auto n = _mm256_set1_epi32( constants::INITIAL_N );
+			auto failed = _mm256_setzero_si256( );
+			alignas( 32 ) std::array<int32_t, LANES> code_points;
+			alignas( 32 ) std::array<int32_t, LANES> positions;
+			for( size_t j = 0; j < g.max_digits; ++j ) {
+				auto const d = load( g.digits[j] );
+				auto const valid = _mm256_cmpgt_epi32( d, _mm256_set1_epi32( NO_DIGIT ) );
+				// Out of digits in the middle of an integer
+				failed = _mm256_or_si256( failed, _mm256_andnot_si256( _mm256_or_si256( valid, _mm256_cmpeq_epi32( w, one ) ),
+				                                                       _mm256_set1_epi32( -1 ) ) );
+
+				i = _mm256_add_epi32( i, _mm256_and_si256( valid, _mm256_mullo_epi32( d, w ) ) );
+				auto const t = _mm256_min_epi32( _mm256_max_epi32( _mm256_sub_epi32( k, bias ), _mm256_set1_epi32( constants::TMIN ) ),
+				                                 _mm256_set1_epi32( constants::TMAX ) );
+				auto done = _mm256_and_si256( valid, _mm256_cmpgt_epi32( t, d ) );
+				auto const more = _mm256_andnot_si256( done, valid );
+				w = _mm256_blendv_epi8( w, _mm256_mullo_epi32( w, _mm256_sub_epi32( base, t ) ), more );
+				k = _mm256_add_epi32( k, _mm256_and_si256( more, base ) );
+				failed = _mm256_or_si256( failed, _mm256_or_si256( _mm256_cmpgt_epi32( i, _mm256_set1_epi32( MAX_I ) ),
+				                                                   _mm256_cmpgt_epi32( w, _mm256_set1_epi32( MAX_W ) ) ) );
+				done = _mm256_andnot_si256( failed, done );
+				if( _mm256_testz_si256( done, done ) ) {
+					continue;
+				}
+				auto const is_first = _mm256_cmpeq_epi32( original_i, _mm256_setzero_si256( ) );
+				bias = _mm256_blendv_epi8( bias, impl::adapt_lanes( _mm256_sub_epi32( i, original_i ), x, is_first, done ), done );
+
+				// The integer is complete, n += i / x and the code point goes in at i % x
+				auto const q = divide_lanes( i, x );
+				auto const code_point = _mm256_add_epi32( n, q );
+				auto const position = _mm256_sub_epi32( i, _mm256_mullo_epi32( q, x ) );
+				auto const invalid = _mm256_or_si256(
+				  _mm256_cmpgt_epi32( code_point, _mm256_set1_epi32( 0x10FFFF ) ),
+				  _mm256_and_si256( _mm256_cmpgt_epi32( code_point, _mm256_set1_epi32( 0xD7FF ) ),
+				                    _mm256_cmpgt_epi32( _mm256_set1_epi32( 0xE000 ), code_point ) ) );
+				failed = _mm256_or_si256( failed, _mm256_and_si256( done, invalid ) );
+				done = _mm256_andnot_si256( invalid, done );
+				n = _mm256_blendv_epi8( n, code_point, done );
+				i = _mm256_blendv_epi8( i, _mm256_add_epi32( position, one ), done );
+				original_i = _mm256_blendv_epi8( original_i, i, done );
+				x = _mm256_add_epi32( x, _mm256_and_si256( done, one ) );
+				w = _mm256_blendv_epi8( w, one, done );
+				k = _mm256_blendv_epi8( k, base, done );
+
+				store( code_points, code_point );
+				store( positions, position );
+				for( auto lanes = lane_mask( done ); lanes != 0; lanes &= lanes - 1 ) {
+					auto const lane = static_cast<size_t>( __builtin_ctz( lanes ) );
+					insert( g, lane, static_cast<size_t>( positions[lane] ), static_cast<uint32_t>( code_points[lane] ) );
+				}
+			}
+			// An integer may still be open if every lane ran out of digits on the same step
+			return lane_mask( _mm256_or_si256( failed, _mm256_andnot_si256( _mm256_cmpeq_epi32( w, one ), _mm256_set1_epi32( -1 ) ) ) );
+		}
+#else
+		// The same steps as the vector decode_lanes for one lane.  Returns false if the lane must use the scalar decoder
+		bool decode_lane( lane_group & g, size_t lane ) noexcept {
+			int32_t i = 0;
+			int32_t original_i = 0;
+			int32_t w = 1;
+			auto k = static_cast<int32_t>( constants::BASE );
+			auto bias = constants::INITIAL_BIAS;
+			auto n = constants::INITIAL_N;
+			for( size_t j = 0; j < g.digit_count[lane]; ++j ) {
+				auto const d = g.digits[j][lane];
+				i += d * w;
+				auto const t = static_cast<int32_t>( punycode::threshold( static_cast<uint32_t>( k ), bias ) );
+				if( d >= t ) {
+					w *= static_cast<int32_t>( constants::BASE ) - t;
+					k += static_cast<int32_t>( constants::BASE );
+				}
+				if( i > MAX_I || w > MAX_W ) {
+					return false;
+				} else if( d >= t ) {
+					continue;
+				}
+				auto const x = static_cast<uint32_t>( g.size[lane] ) + 1;
+				bias = punycode::adapt( static_cast<uint32_t>( i - original_i ), x, 0 == original_i );
+				n += static_cast<uint32_t>( i ) / x;
+				auto const position = static_cast<uint32_t>( i ) % x;
+				if( n > 0x10FFFF || daw::parser::in_range( n, 0xD800u, 0xDFFFu ) ) {
+					return false;
+				}
+				insert( g, lane, position, n );
+				original_i = i = static_cast<int32_t>( position + 1 );
+				w = 1;
+				k = static_cast<int32_t>( constants::BASE );
+			}
+			// Out of digits in the middle of an integer
+			return w == 1;
+		}
+
+		uint32_t decode_lanes( lane_group & g ) noexcept {
+			uint32_t failed = 0;
+			for( size_t lane = 0; lane < g.lane_count; ++lane ) {
+				if( !decode_lane( g, lane ) ) {
+					failed |= 1u << lane;
+				}
+			}
+			return failed;
+		}
+#endif
+
+		void decode_group( lane_group & g, std::vector<daw::string_view> const & labels, std::vector<std::string> & results ) {
+			for( size_t lane = 0; lane < LANES; ++lane ) {
+				if( lane >= g.lane_count ) {
+					g.size[lane] = 0;
+					g.digit_count[lane] = 0;
+				}
+				for( auto j = g.digit_count[lane]; j < g.max_digits; ++j ) {
+					g.digits[j][lane] = NO_DIGIT;
+				}
+			}
+			auto const failed = decode_lanes( g );
+			for( size_t lane = 0; lane < g.lane_count; ++lane ) {
+				auto & result = results[g.index[lane]];
+				if( ( failed & ( 1u << lane ) ) != 0 ) {
+					result = from_puny_code( labels[g.index[lane]] );
+					continue;
+				}
+				// Built on the stack so that result is allocated once
+				std::array<char, MAX_OUTPUT * 4> utf8;
+				auto last = utf8.data( );
+				std::array<uint32_t, MAX_OUTPUT> output;
+				auto const size = static_cast<size_t>( g.size[lane] );
+				for( size_t n = 0; n < size; ++n ) {
+					output[static_cast<size_t>( g.position[lane][n] )] = g.code_points[lane][n];
+				}
+				std::for_each( output.begin( ), output.begin( ) + size, [&last]( uint32_t cp ) {
+					last = write_utf8( last, cp );
+				} );
+				result.assign( utf8.data( ), last );
+			}
+			g.lane_count = 0;
+			g.max_digits = 0;
+		}
+	}    // namespace anonymous
+
+	std::vector<std::string> decode_labels( std::vector<daw::string_view> const & labels ) {
+		std::vector<std::string> results( labels.size( ) );
+		lane_group group;
+		for( size_t n = 0; n < labels.size( ); ++n ) {
+			auto const & label = labels[n];
+			if( !is_simple( label ) ) {
+				results[n] = from_puny_code( label );
+				continue;
+			}
+			if( !begins_with_prefix( label ) ) {
+				results[n] = label.to_string( );
+				continue;
+			}
+			auto const lane = group.lane_count;
+			if( !load_lane( group, lane, label ) ) {
+				results[n] = from_puny_code( label );
+				continue;
+			}
+			group.index[lane] = n;
+			if( ++group.lane_count == LANES ) {
+				decode_group( group, labels, results );
+			}
+		}
+		if( group.lane_count > 0 ) {
+			decode_group( group, labels, results );
+		}
+		return results;
+	}
+}    // namespace daw
@@ -0,0 +1,298 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_impl.h"
+
+namespace daw {
+	namespace {
+		using namespace daw::impl;
+
+		constexpr size_t const LANES = 8;
+		// Longer labels are not valid in DNS and are left to the scalar encoder
+		constexpr size_t const MAX_LANE_CODE_POINTS = 64;
+		constexpr int32_t const PADDING = std::numeric_limits<int32_t>::max( );
+		// n for a lane that has finished, no code point is below or equal to it
+		constexpr int32_t const FINISHED = -1;
+		// Digits in the encoding of a delta below 2^31, every digit after the last divides by at least BASE - TMAX
+		constexpr size_t const MAX_DELTA_DIGITS = 12;
+
+		// Up to LANES labels transposed so that position p of every label is one vector
+		struct lane_group {
+			alignas( 32 ) std::array<std::array<int32_t, LANES>, MAX_LANE_CODE_POINTS> code_points;
+			alignas( 32 ) std::array<int32_t, LANES> n;
+			alignas( 32 ) std::array<int32_t, LANES> delta;
+			alignas( 32 ) std::array<int32_t, LANES> m;
+			alignas( 32 ) std::array<uint32_t, LANES> bias;
+			alignas( 32 ) std::array<uint32_t, LANES> h;
+			alignas( 32 ) std::array<uint32_t, LANES> b;
+			std::array<uint32_t, LANES> size;
+			std::array<std::string, LANES> output;
+			std::array<size_t, LANES> index;
+			size_t lane_count = 0;
+			size_t max_size = 0;
+
+			bool active( size_t lane ) const noexcept {
+				return h[lane] < size[lane];
+			}
+		};
+
+		// Loads the label into a lane, returns false if it must use the scalar encoder
+		bool load_lane( lane_group & group, size_t lane, daw::string_view label ) {
+			auto first = label.begin( );
+			size_t count = 0;
+			std::string basic;
+			while( first != label.end( ) ) {
+				uint32_t cp = 0;
+				if( count == MAX_LANE_CODE_POINTS || !decode_utf8( first, label.end( ), cp ) ) {
+					return false;
+				}
+				// to_puny_code splits the label at a full stop, as decode_labels' is_simple does
+				if( cp == '.' || is_full_stop( cp ) ) {
+					return false;
+				}
+				if( cp < 128 ) {
+					basic += static_cast<char>( to_lower( cp ) );
+				}
+				group.code_points[count++][lane] = static_cast<int32_t>( cp );
+			}
+			for( auto p = count; p < MAX_LANE_CODE_POINTS; ++p ) {
+				group.code_points[p][lane] = PADDING;
+			}
+			group.size[lane] = static_cast<uint32_t>( count );
+			group.b[lane] = group.h[lane] = static_cast<uint32_t>( basic.size( ) );
+			group.n[lane] = static_cast<int32_t>( constants::INITIAL_N );
+			group.delta[lane] = 0;
+			group.bias[lane] = constants::INITIAL_BIAS;
+			group.output[lane] = constants::PREFIX.to_string( ) + basic;
+			if( !basic.empty( ) ) {
+				group.output[lane] += constants::DELIMITER;
+			}
+			group.max_size = std::max( group.max_size, count );
+			return true;
+		}
+
+		// The smallest code point >= n in each lane
+		void find_next_code_points( lane_group & g ) noexcept {
+#ifdef __AVX2__
+			auto const n = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.n.data( ) ) );
+			auto const padding = _mm256_set1_epi32( PADDING );
+			auto m = padding;
+			for( size_t p = 0; p < g.max_size; ++p ) {
+				auto const cp = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.code_points[p].data( ) ) );
+				auto const below = _mm256_cmpgt_epi32( n, cp );
+				m = _mm256_min_epi32( m, _mm256_blendv_epi8( cp, padding, below ) );
+			}
+			_mm256_store_si256( reinterpret_cast<__m256i *>( g.m.data( ) ), m );
+#else
+			g.m.fill( PADDING );
+			for( size_t p = 0; p < g.max_size; ++p ) {
+				for( size_t lane = 0; lane < LANES; ++lane ) {
+					auto const cp = g.code_points[p][lane];
+					if( cp >= g.n[lane] && cp < g.m[lane] ) {
+						g.m[lane] = cp;
+					}
+				}
+			}
+#endif
+		}
+
+#ifdef __AVX2__
+		template<typename T>
+		__m256i load( std::array<T, LANES> const & values ) noexcept {
+			return _mm256_load_si256( reinterpret_cast<__m256i const *>( values.data( ) ) );
+		}
+
+		template<typename T>
+		void store( std::array<T, LANES> & values, __m256i v ) noexcept {
+			_mm256_store_si256( reinterpret_cast<__m256i *>( values.data( ) ), v );
+		}
+
+		// encode_int and adapt for every lane in mask at once.  The digits are found for all lanes together and only
+		// appending them to each lane's output is per lane
+		void emit_lanes( lane_group & g, __m256i mask ) {
+			auto const base = _mm256_set1_epi32( constants::BASE );
+			auto const delta = load( g.delta );
+			auto const bias = load( g.bias );
+			alignas( 32 ) std::array<std::array<int32_t, LANES>, MAX_DELTA_DIGITS> digits;
+			size_t digit_count = 0;
+			auto q = delta;
+			auto k = base;
+			auto more = mask;
+			while( !_mm256_testz_si256( more, more ) ) {
+				auto const t = _mm256_min_epi32( _mm256_max_epi32( _mm256_sub_epi32( k, bias ), _mm256_set1_epi32( constants::TMIN ) ),
+				                                 _mm256_set1_epi32( constants::TMAX ) );
+				auto const last = _mm256_cmpgt_epi32( t, q );
+				auto const step = _mm256_sub_epi32( base, t );
+				auto const excess = _mm256_max_epi32( _mm256_sub_epi32( q, t ), _mm256_setzero_si256( ) );
+				auto const quotient = divide_lanes( excess, step );
+				auto const digit = _mm256_blendv_epi8(
+				  _mm256_add_epi32( t, _mm256_sub_epi32( excess, _mm256_mullo_epi32( quotient, step ) ) ), q, last );
+				store( digits[digit_count++], _mm256_blendv_epi8( _mm256_set1_epi32( -1 ), digit, more ) );
+				q = quotient;
+				k = _mm256_add_epi32( k, base );
+				more = _mm256_andnot_si256( last, more );
+			}
+			auto lanes = static_cast<uint32_t>( _mm256_movemask_ps( _mm256_castsi256_ps( mask ) ) );
+			for( ; lanes != 0; lanes &= lanes - 1 ) {
+				auto const lane = static_cast<size_t>( __builtin_ctz( lanes ) );
+				for( size_t j = 0; j < digit_count && digits[j][lane] >= 0; ++j ) {
+					g.output[lane].push_back( punycode_parameters::encode_digit( static_cast<uint32_t>( digits[j][lane] ) ) );
+				}
+			}
+
+			auto const h = load( g.h );
+			auto const n_points = _mm256_add_epi32( h, _mm256_set1_epi32( 1 ) );
+			auto const new_bias = impl::adapt_lanes( delta, n_points, _mm256_cmpeq_epi32( load( g.b ), h ), mask );
+			store( g.bias, _mm256_blendv_epi8( bias, new_bias, mask ) );
+			store( g.delta, _mm256_andnot_si256( mask, delta ) );
+			// The mask is -1 per lane, subtracting it increments
+			store( g.h, _mm256_sub_epi32( h, mask ) );
+		}
+#else
+		void emit( lane_group & g, size_t lane ) {
+			auto const delta = static_cast<uint32_t>( g.delta[lane] );
+			punycode::encode_int( g.bias[lane], delta, g.output[lane] );
+			g.bias[lane] = static_cast<uint32_t>( punycode::adapt( delta, g.h[lane] + 1, g.b[lane] == g.h[lane] ) );
+			g.delta[lane] = 0;
+			++g.h[lane];
+		}
+#endif
+
+		// One pass over every position: count code points below n and emit a delta at each one equal to n
+		void scan_positions( lane_group & g ) {
+#ifdef __AVX2__
+			auto const n = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.n.data( ) ) );
+			auto delta = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.delta.data( ) ) );
+			for( size_t p = 0; p < g.max_size; ++p ) {
+				auto const cp = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.code_points[p].data( ) ) );
+				// The compare mask is -1 per lane, subtracting it increments
+				delta = _mm256_sub_epi32( delta, _mm256_cmpgt_epi32( n, cp ) );
+				auto const equal = _mm256_cmpeq_epi32( n, cp );
+				if( !_mm256_testz_si256( equal, equal ) ) {
+					_mm256_store_si256( reinterpret_cast<__m256i *>( g.delta.data( ) ), delta );
+					emit_lanes( g, equal );
+					delta = _mm256_load_si256( reinterpret_cast<__m256i const *>( g.delta.data( ) ) );
+				}
+			}
+			_mm256_store_si256( reinterpret_cast<__m256i *>( g.delta.data( ) ), delta );
+#else
+			for( size_t p = 0; p < g.max_size; ++p ) {
+				for( size_t lane = 0; lane < LANES; ++lane ) {
+					auto const cp = g.code_points[p][lane];
+					if( cp < g.n[lane] ) {
+						++g.delta[lane];
+					} else if( cp == g.n[lane] ) {
+						emit( g, lane );
+					}
+				}
+			}
+#endif
+		}
+
+		void encode_group( lane_group & g, std::vector<std::string> & results ) {
+			for( size_t lane = g.lane_count; lane < LANES; ++lane ) {
+				g.size[lane] = g.h[lane] = 0;
+				for( size_t p = 0; p < g.max_size; ++p ) {
+					g.code_points[p][lane] = PADDING;
+				}
+			}
+			auto const update_finished = [&g]( ) {
+				bool any = false;
+				for( size_t lane = 0; lane < LANES; ++lane ) {
+					if( g.active( lane ) ) {
+						any = true;
+					} else {
+						g.n[lane] = FINISHED;
+					}
+				}
+				return any;
+			};
+			while( update_finished( ) ) {
+				find_next_code_points( g );
+				for( size_t lane = 0; lane < LANES; ++lane ) {
+					if( g.active( lane ) ) {
+						g.delta[lane] += ( g.m[lane] - g.n[lane] ) * static_cast<int32_t>( g.h[lane] + 1 );
+						g.n[lane] = g.m[lane];
+					}
+				}
+				scan_positions( g );
+				for( size_t lane = 0; lane < LANES; ++lane ) {
+					if( g.n[lane] != FINISHED ) {
+						++g.delta[lane];
+						++g.n[lane];
+					}
+				}
+			}
+			for( size_t lane = 0; lane < g.lane_count; ++lane ) {
+				results[g.index[lane]] = std::move( g.output[lane] );
+			}
+			g.lane_count = 0;
+			g.max_size = 0;
+		}
+	}    // namespace anonymous
+
+	std::vector<std::string> encode_labels( std::vector<daw::string_view> const & labels ) {
+		std::vector<std::string> results( labels.size( ) );
+		lane_group group;
+		for( size_t n = 0; n < labels.size( ); ++n ) {
+			auto const & label = labels[n];
+			auto const ascii = std::all_of( label.begin( ), label.end( ), []( char c ) {
+				return static_cast<unsigned char>( c ) < 128;
+			} );
+			if( ascii ) {
+				results[n].reserve( label.size( ) );
+				for( auto c : label ) {
+					results[n] += static_cast<char>( to_lower( c ) );
+				}
+				continue;
+			}
+			auto const lane = group.lane_count;
+			if( !load_lane( group, lane, label ) ) {
+				results[n] = to_puny_code( label );
+				continue;
+			}
+			group.index[lane] = n;
+			if( ++group.lane_count == LANES ) {
+				encode_group( group, results );
+			}
+		}
+		if( group.lane_count > 0 ) {
+			encode_group( group, results );
+		}
+		return results;
+	}
+}    // namespace daw
@@ -0,0 +1,281 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <daw/daw_parser_helper.h>
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+
+namespace daw {
+	namespace {
+		constexpr size_t const MAX_ASCII_HOST_SIZE = 253;
+		constexpr size_t const MAX_LABEL_SIZE = 63;
+
+		struct scan_masks {
+			uint32_t dots;
+			uint32_t non_ascii;
+			uint32_t non_ldh;
+		};
+
+		constexpr bool is_ldh( char c ) noexcept {
+			return daw::parser::in_range( c, 'a', 'z' ) || daw::parser::in_range( c, 'A', 'Z' ) ||
+			       daw::parser::in_range( c, '0', '9' ) || c == '-';
+		}
+
+		constexpr bool is_hex( char c ) noexcept {
+			return daw::parser::in_range( c, '0', '9' ) || daw::parser::in_range( c, 'a', 'f' ) ||
+			       daw::parser::in_range( c, 'A', 'F' );
+		}
+
+		// One bit per byte of the block starting at first, for up to 16 bytes
+		scan_masks scan_block( char const * first, size_t size ) noexcept {
+			scan_masks result{ 0, 0, 0 };
+#ifdef __SSE2__
+			if( size == 16 ) {
+				auto const block = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first ) );
+				auto const in_range = [&block]( char lo, char hi ) {
+					// Signed compares, bytes >= 0x80 are negative and never in an ASCII range
+					return _mm_and_si128( _mm_cmpgt_epi8( block, _mm_set1_epi8( static_cast<char>( lo - 1 ) ) ),
+					                      _mm_cmplt_epi8( block, _mm_set1_epi8( static_cast<char>( hi + 1 ) ) ) );
+				};
+				auto const dots = _mm_cmpeq_epi8( block, _mm_set1_epi8( '.' ) );
+				auto ldh = _mm_or_si128( in_range( 'a', 'z' ), in_range( 'A', 'Z' ) );
+				ldh = _mm_or_si128( ldh, in_range( '0', '9' ) );
+				ldh = _mm_or_si128( ldh, _mm_cmpeq_epi8( block, _mm_set1_epi8( '-' ) ) );
+				ldh = _mm_or_si128( ldh, dots );
+				auto const non_ascii = static_cast<uint32_t>( _mm_movemask_epi8( block ) );
+				result.dots = static_cast<uint32_t>( _mm_movemask_epi8( dots ) );
+				result.non_ascii = non_ascii;
+				result.non_ldh = ~static_cast<uint32_t>( _mm_movemask_epi8( ldh ) ) & ~non_ascii & 0xFFFFu;
+				return result;
+			}
+#endif
+			for( size_t n = 0; n < size; ++n ) {
+				auto const c = first[n];
+				auto const bit = uint32_t{ 1 } << n;
+				if( static_cast<unsigned char>( c ) >= 128 ) {
+					result.non_ascii |= bit;
+				} else if( c == '.' ) {
+					result.dots |= bit;
+				} else if( !is_ldh( c ) ) {
+					result.non_ldh |= bit;
+				}
+			}
+			return result;
+		}
+
+		size_t count_trailing_zeros( uint32_t value ) noexcept {
+#if defined( __GNUC__ ) || defined( __clang__ )
+			return static_cast<size_t>( __builtin_ctz( value ) );
+#else
+			size_t result = 0;
+			while( ( value & 1 ) == 0 ) {
+				value >>= 1;
+				++result;
+			}
+			return result;
+#endif
+		}
+
+		bool is_ipv4( daw::string_view host ) noexcept {
+			size_t octets = 0;
+			auto it = host.begin( );
+			while( it != host.end( ) ) {
+				uint32_t value = 0;
+				size_t digits = 0;
+				for( ; it != host.end( ) && daw::parser::in_range( *it, '0', '9' ); ++it, ++digits ) {
+					value = value * 10 + static_cast<uint32_t>( *it - '0' );
+				}
+				if( digits == 0 || digits > 3 || value > 255 || ++octets > 4 ) {
+					return false;
+				}
+				if( it != host.end( ) ) {
+					if( *it != '.' || it + 1 == host.end( ) ) {
+						return false;
+					}
+					++it;
+				}
+			}
+			return octets == 4;
+		}
+
+		bool is_ipv6( daw::string_view host ) noexcept {
+			if( host.size( ) < 2 ) {
+				return false;
+			}
+			size_t groups = 0;
+			bool has_compression = false;
+			auto it = host.begin( );
+			if( *it == ':' ) {
+				if( *( it + 1 ) != ':' ) {
+					return false;
+				}
+				has_compression = true;
+				it += 2;
+			}
+			while( it != host.end( ) ) {
+				auto const group_start = it;
+				size_t digits = 0;
+				for( ; it != host.end( ) && is_hex( *it ); ++it ) {
+					++digits;
+				}
+				if( it != host.end( ) && *it == '.' ) {
+					// Embedded IPv4 in the final two groups
+					if( !is_ipv4( daw::string_view{ group_start, static_cast<size_t>( host.end( ) - group_start ) } ) ) {
+						return false;
+					}
+					groups += 2;
+					break;
+				}
+				if( digits == 0 || digits > 4 || ++groups > 8 ) {
+					return false;
+				}
+				if( it == host.end( ) ) {
+					break;
+				}
+				if( *it != ':' || ++it == host.end( ) ) {
+					return false;
+				}
+				if( *it == ':' ) {
+					if( has_compression ) {
+						return false;
+					}
+					has_compression = true;
+					++it;
+				}
+			}
+			return has_compression ? groups < 8 : groups == 8;
+		}
+
+		bool has_ace_prefix( daw::string_view label ) noexcept {
+			return label.size( ) >= 4 && ( label[0] | 32 ) == 'x' && ( label[1] | 32 ) == 'n' && label[2] == '-' &&
+			       label[3] == '-';
+		}
+	}    // namespace anonymous
+
+	hostname_classification classify_hostname( daw::string_view host ) noexcept {
+		hostname_classification result;
+		result.type = hostname_class::invalid;
+		result.label_count = 0;
+
+		if( host.empty( ) || host.size( ) > std::numeric_limits<uint16_t>::max( ) ) {
+			return result;
+		}
+		if( host.front( ) == '[' ) {
+			if( host.back( ) == ']' && is_ipv6( host.substr( 1, host.size( ) - 2 ) ) ) {
+				result.type = hostname_class::ipv6_literal;
+			}
+			return result;
+		}
+		if( host.back( ) == '.' ) {
+			host.remove_suffix( 1 );
+			if( host.empty( ) ) {
+				return result;
+			}
+		}
+
+		bool any_non_ascii = false;
+		size_t label_start = 0;
+		auto const add_label = [&result, &host]( size_t first, size_t last ) {
+			if( last == first || result.label_count == hostname_classification::MAX_LABELS ) {
+				return false;
+			}
+			result.label_offsets[result.label_count] = static_cast<uint16_t>( first );
+			result.label_sizes[result.label_count] = static_cast<uint16_t>( last - first );
+			++result.label_count;
+			return true;
+		};
+		for( size_t pos = 0; pos < host.size( ); pos += 16 ) {
+			auto const block_size = std::min( size_t{ 16 }, host.size( ) - pos );
+			auto const masks = scan_block( host.data( ) + pos, block_size );
+			if( masks.non_ldh != 0 ) {
+				if( is_ipv6( host ) ) {
+					result.type = hostname_class::ipv6_literal;
+					result.label_count = 0;
+				}
+				return result;
+			}
+			any_non_ascii |= masks.non_ascii != 0;
+			for( auto dots = masks.dots; dots != 0; dots &= dots - 1 ) {
+				auto const dot = pos + count_trailing_zeros( dots );
+				if( !add_label( label_start, dot ) ) {
+					return result;
+				}
+				label_start = dot + 1;
+			}
+		}
+		if( !add_label( label_start, host.size( ) ) ) {
+			return result;
+		}
+
+		if( !any_non_ascii && host.size( ) > MAX_ASCII_HOST_SIZE ) {
+			return result;
+		}
+		bool any_ace = false;
+		bool all_numeric = true;
+		for( size_t n = 0; n < result.label_count; ++n ) {
+			auto const lbl = result.label( host, n );
+			bool const ascii_label = std::all_of( lbl.begin( ), lbl.end( ), []( char c ) {
+				return static_cast<unsigned char>( c ) < 128;
+			} );
+			if( ascii_label ) {
+				if( lbl.size( ) > MAX_LABEL_SIZE || lbl.front( ) == '-' || lbl.back( ) == '-' ) {
+					return result;
+				}
+				any_ace |= has_ace_prefix( lbl );
+			}
+			all_numeric = all_numeric && std::all_of( lbl.begin( ), lbl.end( ), []( char c ) {
+				              return daw::parser::in_range( c, '0', '9' );
+			              } );
+		}
+		auto const last_label = result.label( host, result.label_count - 1 );
+		if( all_numeric ) {
+			if( is_ipv4( host ) ) {
+				result.type = hostname_class::ipv4_literal;
+			}
+			return result;
+		}
+		if( std::all_of( last_label.begin( ), last_label.end( ), []( char c ) {
+			    return daw::parser::in_range( c, '0', '9' );
+		    } ) ) {
+			// A top level domain is never all digits
+			return result;
+		}
+		if( any_non_ascii ) {
+			result.type = hostname_class::contains_non_ascii;
+		} else if( any_ace ) {
+			result.type = hostname_class::contains_ace;
+		} else {
+			result.type = hostname_class::ascii_ldh;
+		}
+		return result;
+	}
+}    // namespace daw
@@ -0,0 +1,309 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_index.h"
+
+namespace daw {
+	namespace {
+		constexpr char const MAGIC[8] = { 'P', 'U', 'N', 'Y', 'I', 'D', 'X', '1' };
+		constexpr uint32_t const VERSION = 1;
+		constexpr uint32_t const ENDIAN_MARKER = 0x01020304;
+
+		struct index_header {
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order;
+			uint64_t entry_count;
+			uint64_t bucket_count;
+			uint64_t to_ace_offset;
+			uint64_t to_unicode_offset;
+			uint64_t strings_offset;
+			uint64_t file_size;
+			uint64_t checksum;
+			uint64_t reserved;
+		};
+		static_assert( sizeof( index_header ) == 80, "Unexpected header layout" );
+
+		// An empty slot has a hash of 0
+		struct index_slot {
+			uint64_t hash;
+			uint64_t key_offset;
+			uint64_t value_offset;
+			uint32_t key_size;
+			uint32_t value_size;
+		};
+		static_assert( sizeof( index_slot ) == 32, "Unexpected slot layout" );
+
+		uint64_t hash_key( daw::string_view key ) noexcept {
+			uint64_t result = 14695981039346656037ULL;
+			for( auto c : key ) {
+				result ^= static_cast<unsigned char>( c );
+				result *= 1099511628211ULL;
+			}
+			return result == 0 ? 1 : result;
+		}
+
+		uint64_t checksum( char const * first, char const * last ) noexcept {
+			uint64_t result = 14695981039346656037ULL;
+			for( ; first != last; ++first ) {
+				result ^= static_cast<unsigned char>( *first );
+				result *= 1099511628211ULL;
+			}
+			return result;
+		}
+
+		struct table_builder {
+			std::vector<index_slot> slots;
+
+			explicit table_builder( size_t bucket_count ) : slots( bucket_count, index_slot{ 0, 0, 0, 0, 0 } ) {}
+
+			void add( daw::string_view key, uint64_t key_offset, uint64_t value_offset, size_t value_size,
+			          std::string const & strings ) {
+				auto const h = hash_key( key );
+				auto const mask = slots.size( ) - 1;
+				for( auto pos = h & mask;; pos = ( pos + 1 ) & mask ) {
+					auto & slot = slots[pos];
+					if( slot.hash == 0 ) {
+						slot = index_slot{ h, key_offset, value_offset, static_cast<uint32_t>( key.size( ) ),
+						                   static_cast<uint32_t>( value_size ) };
+						return;
+					}
+					if( slot.hash == h && slot.key_size == key.size( ) &&
+					    std::equal( key.begin( ), key.end( ), strings.data( ) + slot.key_offset ) ) {
+						return;
+					}
+				}
+			}
+		};
+	}    // namespace anonymous
+
+	struct conversion_index::impl {
+		boost::iostreams::mapped_file_source file;
+		index_header const * header;
+		index_slot const * to_ace;
+		index_slot const * to_unicode;
+		char const * strings;
+		uint64_t strings_size;
+
+		// The checksum is only read by verify( ), so a slot pointing outside the strings is treated as a miss
+		bool in_strings( uint64_t offset, uint64_t size ) const noexcept {
+			return offset <= strings_size && size <= strings_size - offset;
+		}
+
+		bool find( index_slot const * table, daw::string_view key, daw::string_view & value ) const noexcept {
+			auto const h = hash_key( key );
+			auto const mask = header->bucket_count - 1;
+			// Bounded so that a corrupt table without an empty slot still ends
+			auto pos = h & mask;
+			for( uint64_t probe = 0; probe < header->bucket_count; ++probe, pos = ( pos + 1 ) & mask ) {
+				auto const & slot = table[pos];
+				if( slot.hash == 0 ) {
+					return false;
+				}
+				if( slot.hash == h && slot.key_size == key.size( ) && in_strings( slot.key_offset, slot.key_size ) &&
+				    std::equal( key.begin( ), key.end( ), strings + slot.key_offset ) ) {
+					if( !in_strings( slot.value_offset, slot.value_size ) ) {
+						return false;
+					}
+					value = daw::string_view{ strings + slot.value_offset, slot.value_size };
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	conversion_index::conversion_index( std::shared_ptr<impl const> i ) noexcept : m_impl( std::move( i ) ) {}
+
+	conversion_index conversion_index::open( std::string const & path ) {
+		auto result = std::make_shared<impl>( );
+		result->file.open( path );
+		auto const data = result->file.data( );
+		auto const size = result->file.size( );
+		if( size < sizeof( index_header ) ) {
+			throw std::runtime_error( path + " is not a conversion index" );
+		}
+		result->header = reinterpret_cast<index_header const *>( data );
+		auto const & header = *result->header;
+		if( !std::equal( std::begin( MAGIC ), std::end( MAGIC ), header.magic ) || header.version != VERSION ||
+		    header.byte_order != ENDIAN_MARKER ) {
+			throw std::runtime_error( path + " is not a compatible conversion index" );
+		}
+		// Written so that no sum can overflow
+		auto const fits = [size]( uint64_t offset, uint64_t length ) {
+			return offset <= size && length <= size - offset && offset % alignof( index_slot ) == 0;
+		};
+		if( header.file_size != size || header.bucket_count == 0 || header.bucket_count > size / sizeof( index_slot ) ||
+		    ( header.bucket_count & ( header.bucket_count - 1 ) ) != 0 ) {
+			throw std::runtime_error( path + " is truncated or corrupt" );
+		}
+		auto const table_size = header.bucket_count * sizeof( index_slot );
+		if( !fits( header.to_ace_offset, table_size ) || !fits( header.to_unicode_offset, table_size ) ||
+		    header.strings_offset > size ) {
+			throw std::runtime_error( path + " is truncated or corrupt" );
+		}
+		result->to_ace = reinterpret_cast<index_slot const *>( data + header.to_ace_offset );
+		result->to_unicode = reinterpret_cast<index_slot const *>( data + header.to_unicode_offset );
+		result->strings = data + header.strings_offset;
+		result->strings_size = size - header.strings_offset;
+		return conversion_index( std::move( result ) );
+	}
+
+	bool conversion_index::verify( ) const {
+		auto const data = m_impl->file.data( );
+		return checksum( data + sizeof( index_header ), data + m_impl->file.size( ) ) == m_impl->header->checksum;
+	}
+
+	size_t conversion_index::size( ) const noexcept {
+		return static_cast<size_t>( m_impl->header->entry_count );
+	}
+
+	bool conversion_index::find_ace( daw::string_view unicode, daw::string_view & ace ) const noexcept {
+		return m_impl->find( m_impl->to_ace, unicode, ace );
+	}
+
+	bool conversion_index::find_unicode( daw::string_view ace, daw::string_view & unicode ) const noexcept {
+		return m_impl->find( m_impl->to_unicode, ace, unicode );
+	}
+
+	std::string conversion_index::to_puny_code( daw::string_view input ) const {
+		daw::string_view result;
+		if( find_ace( input, result ) ) {
+			return std::string( result.data( ), result.size( ) );
+		}
+		return daw::to_puny_code( input );
+	}
+
+	std::string conversion_index::from_puny_code( daw::string_view input ) const {
+		daw::string_view result;
+		if( find_unicode( input, result ) ) {
+			return std::string( result.data( ), result.size( ) );
+		}
+		return daw::from_puny_code( input );
+	}
+
+	void write_conversion_index( std::vector<std::string> const & hostnames, std::string const & path ) {
+		// Each distinct conversion stores its Unicode and ACE forms once; both tables point into the same strings
+		struct pair_t {
+			uint64_t unicode_offset;
+			uint64_t ace_offset;
+			size_t unicode_size;
+			size_t ace_size;
+			uint64_t input_offset;
+			size_t input_size;
+		};
+		auto sorted_hostnames = hostnames;
+		std::sort( sorted_hostnames.begin( ), sorted_hostnames.end( ) );
+		sorted_hostnames.erase( std::unique( sorted_hostnames.begin( ), sorted_hostnames.end( ) ), sorted_hostnames.end( ) );
+
+		std::string strings;
+		std::vector<pair_t> pairs;
+		for( auto const & host : sorted_hostnames ) {
+			if( host.empty( ) ) {
+				continue;
+			}
+			std::string ace;
+			std::string unicode;
+			try {
+				ace = daw::to_puny_code( host );
+				unicode = daw::from_puny_code( ace );
+			} catch( std::exception const & ) {
+				continue;
+			}
+			if( ace == unicode ) {
+				continue;
+			}
+			pair_t p;
+			p.unicode_offset = strings.size( );
+			p.unicode_size = unicode.size( );
+			strings += unicode;
+			p.ace_offset = strings.size( );
+			p.ace_size = ace.size( );
+			strings += ace;
+			p.input_offset = p.unicode_offset;
+			p.input_size = p.unicode_size;
+			if( host != unicode && host != ace ) {
+				// Keep the spelling that was given too, e.g. upper case ASCII in a Unicode name
+				p.input_offset = strings.size( );
+				p.input_size = host.size( );
+				strings += host;
+			}
+			pairs.push_back( p );
+		}
+
+		size_t bucket_count = 16;
+		while( bucket_count < 4 * pairs.size( ) ) {
+			bucket_count *= 2;
+		}
+		table_builder to_ace( bucket_count );
+		table_builder to_unicode( bucket_count );
+		for( auto const & p : pairs ) {
+			daw::string_view const unicode{ strings.data( ) + p.unicode_offset, p.unicode_size };
+			daw::string_view const ace{ strings.data( ) + p.ace_offset, p.ace_size };
+			to_ace.add( unicode, p.unicode_offset, p.ace_offset, p.ace_size, strings );
+			if( p.input_offset != p.unicode_offset ) {
+				daw::string_view const input{ strings.data( ) + p.input_offset, p.input_size };
+				to_ace.add( input, p.input_offset, p.ace_offset, p.ace_size, strings );
+			}
+			to_unicode.add( ace, p.ace_offset, p.unicode_offset, p.unicode_size, strings );
+		}
+
+		auto const table_size = bucket_count * sizeof( index_slot );
+		index_header header;
+		std::memset( &header, 0, sizeof( header ) );
+		std::copy( std::begin( MAGIC ), std::end( MAGIC ), header.magic );
+		header.version = VERSION;
+		header.byte_order = ENDIAN_MARKER;
+		header.entry_count = pairs.size( );
+		header.bucket_count = bucket_count;
+		header.to_ace_offset = sizeof( index_header );
+		header.to_unicode_offset = header.to_ace_offset + table_size;
+		header.strings_offset = header.to_unicode_offset + table_size;
+		header.file_size = header.strings_offset + strings.size( );
+
+		std::string payload;
+		payload.reserve( header.file_size - sizeof( index_header ) );
+		payload.append( reinterpret_cast<char const *>( to_ace.slots.data( ) ), table_size );
+		payload.append( reinterpret_cast<char const *>( to_unicode.slots.data( ) ), table_size );
+		payload += strings;
+		header.checksum = checksum( payload.data( ), payload.data( ) + payload.size( ) );
+
+		std::ofstream out( path, std::ios::binary | std::ios::trunc );
+		out.write( reinterpret_cast<char const *>( &header ), sizeof( header ) );
+		out.write( payload.data( ), static_cast<std::streamsize>( payload.size( ) ) );
+		if( !out ) {
+			throw std::runtime_error( "Could not write " + path );
+		}
+	}
+}    // namespace daw
@@ -0,0 +1,95 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_hostname.h"
+
+namespace daw {
+	// C++14 needs a definition when MAX_SIZE is bound to a reference, as std::min( size, MAX_SIZE ) does
+	constexpr size_t const hostname::MAX_SIZE;
+
+	namespace {
+		template<typename Convert>
+		hostname convert_to_hostname( daw::string_view input, Convert convert ) {
+			hostname result;
+			auto const size = convert( input, result.data( ), hostname::MAX_SIZE );
+			if( size > hostname::MAX_SIZE ) {
+				throw std::runtime_error( "The converted hostname is longer than 255 bytes" );
+			}
+			result.resize( size );
+			return result;
+		}
+	}    // namespace anonymous
+
+	hostname to_puny_code_hostname( daw::string_view input ) {
+		return convert_to_hostname( input, []( daw::string_view in, char * out, size_t capacity ) {
+			return to_puny_code( in, out, capacity );
+		} );
+	}
+
+	hostname from_puny_code_hostname( daw::string_view input ) {
+		return convert_to_hostname( input, []( daw::string_view in, char * out, size_t capacity ) {
+			return from_puny_code( in, out, capacity );
+		} );
+	}
+
+	shared_hostname::data_t::data_t( std::string ace_form ) : ace( std::move( ace_form ) ), hash( impl::hash_bytes( daw::string_view{ ace.data( ), ace.size( ) } ) ) {
+		size_t position = 0;
+		while( true ) {
+			label_offsets.push_back( static_cast<uint16_t>( position ) );
+			auto const dot = ace.find( '.', position );
+			if( dot == std::string::npos ) {
+				break;
+			}
+			position = dot + 1;
+		}
+	}
+
+	shared_hostname::shared_hostname( daw::string_view input ) : m_data( std::make_shared<data_t>( to_puny_code( input ) ) ) {
+		if( m_data->ace.size( ) > std::numeric_limits<uint16_t>::max( ) ) {
+			throw std::runtime_error( "Hostname is too long" );
+		}
+	}
+
+	daw::string_view shared_hostname::unicode( ) const {
+		std::call_once( m_data->unicode_flag, [this]( ) {
+			m_data->unicode = from_puny_code( ace( ) );
+		} );
+		return daw::string_view{ m_data->unicode.data( ), m_data->unicode.size( ) };
+	}
+
+	daw::string_view shared_hostname::label( size_t n ) const noexcept {
+		auto const & offsets = m_data->label_offsets;
+		auto const first = offsets[n];
+		auto const last = n + 1 < offsets.size( ) ? offsets[n + 1] - 1u : m_data->ace.size( );
+		return daw::string_view{ m_data->ace.data( ) + first, last - first };
+	}
+}    // namespace daw
@@ -0,0 +1,510 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_dictionary.h"
+
+namespace daw {
+	namespace {
+		constexpr char const MAGIC[8] = { 'P', 'U', 'N', 'Y', 'D', 'I', 'C', '1' };
+		constexpr uint32_t const VERSION = 1;
+		constexpr uint32_t const ENDIAN_MARKER = 0x01020304;
+
+		// The data section holds, for each block, the first key and then each following key as the size of the prefix
+		// it shares with the previous key, one byte as no key is longer than 255, and the rest of it.  Keys are ASCII,
+		// so instead of storing their sizes the last byte of each is marked with the high bit
+		struct dictionary_header {
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order;
+			uint64_t entry_count;
+			uint64_t block_size;
+			uint64_t block_count;
+			uint64_t restarts_offset;
+			uint64_t data_offset;
+			uint64_t file_size;
+			uint64_t checksum;
+			uint64_t reserved;
+		};
+		static_assert( sizeof( dictionary_header ) == 80, "Unexpected header layout" );
+
+		// Each block's offset in the data section and the first 8 bytes of its first key as a big endian integer,
+		// zero padded.  A key's prefix is never greater than that of a greater key, so the binary search over blocks
+		// only reads the data section when the prefixes are equal
+		struct restart_point {
+			uint64_t offset;
+			uint64_t prefix;
+		};
+		static_assert( sizeof( restart_point ) == 16, "Unexpected restart layout" );
+
+		uint64_t key_prefix( daw::string_view key ) noexcept {
+			uint64_t result = 0;
+			for( size_t n = 0; n < sizeof( uint64_t ); ++n ) {
+				result <<= 8u;
+				if( n < key.size( ) ) {
+					result |= static_cast<unsigned char>( key[n] );
+				}
+			}
+			return result;
+		}
+
+		uint64_t checksum( char const * first, char const * last ) noexcept {
+			uint64_t result = 14695981039346656037ULL;
+			for( ; first != last; ++first ) {
+				result ^= static_cast<unsigned char>( *first );
+				result *= 1099511628211ULL;
+			}
+			return result;
+		}
+
+		// Keys are the labels in reverse order separated by '\0', which sorts below every label character, so
+		// ordering keys bytewise is DNS canonical order and a zone's names all begin with the zone's key
+		size_t to_key( daw::string_view name, char * out ) noexcept {
+			size_t size = 0;
+			auto last = name.size( );
+			while( true ) {
+				auto first = last;
+				while( first > 0 && name[first - 1] != '.' ) {
+					--first;
+				}
+				std::copy( name.data( ) + first, name.data( ) + last, out + size );
+				size += last - first;
+				if( first == 0 ) {
+					return size;
+				}
+				out[size++] = '\0';
+				last = first - 1;
+			}
+		}
+
+		size_t to_name( daw::string_view key, char * out ) noexcept {
+			size_t size = 0;
+			auto last = key.size( );
+			while( true ) {
+				auto first = last;
+				while( first > 0 && key[first - 1] != '\0' ) {
+					--first;
+				}
+				std::copy( key.data( ) + first, key.data( ) + last, out + size );
+				size += last - first;
+				if( first == 0 ) {
+					return size;
+				}
+				out[size++] = '.';
+				last = first - 1;
+			}
+		}
+
+		// Returns the size of the run, 0 if it does not end before last or is longer than capacity
+		size_t read_run( char const * & pos, char const * last, char * out, size_t capacity ) noexcept {
+			size_t size = 0;
+			while( pos != last && size < capacity ) {
+				auto const c = static_cast<unsigned char>( *pos++ );
+				out[size++] = static_cast<char>( c & 0x7Fu );
+				if( ( c & 0x80u ) != 0 ) {
+					return size;
+				}
+			}
+			return 0;
+		}
+
+		// The data section is followed by RUN_PADDING zero bytes so runs can be scanned a word at a time.  open( )
+		// checks that the last data byte ends a run, so a scan that starts inside the data section ends inside it
+		constexpr size_t const RUN_PADDING = sizeof( uint64_t );
+
+		void skip_run( char const * & pos ) noexcept {
+			while( true ) {
+				uint64_t word;
+				std::memcpy( &word, pos, sizeof( word ) );
+				auto const marks = word & 0x8080808080808080ULL;
+				if( marks != 0 ) {
+					pos += static_cast<size_t>( __builtin_ctzll( marks ) ) / 8 + 1;
+					return;
+				}
+				pos += sizeof( word );
+			}
+		}
+
+		// Compares key with the stored key made of key's first `first` bytes followed by the run at pos, without
+		// copying.  Returns the order of the stored key, sets matched to the length of their common prefix and leaves
+		// pos after the run
+		int compare_run( char const * & pos, daw::string_view key, size_t first, size_t & matched ) noexcept {
+			for( auto n = first;; ++n ) {
+				auto const c = static_cast<unsigned char>( *pos++ );
+				auto const is_last = ( c & 0x80u ) != 0;
+				auto const stored = c & 0x7Fu;
+				if( n == key.size( ) || stored != static_cast<unsigned char>( key[n] ) ) {
+					matched = n;
+					if( !is_last ) {
+						skip_run( pos );
+					}
+					return n == key.size( ) || stored > static_cast<unsigned char>( key[n] ) ? 1 : -1;
+				}
+				if( is_last ) {
+					matched = n + 1;
+					return matched == key.size( ) ? 0 : -1;
+				}
+			}
+		}
+
+		void append_run( std::string & data, std::string const & key, size_t first ) {
+			data.append( key, first, key.size( ) - first - 1 );
+			data += static_cast<char>( static_cast<unsigned char>( key.back( ) ) | 0x80u );
+		}
+
+		// Converts a hostname to its key, false if it cannot be converted or is too long
+		bool make_key( daw::string_view hostname, std::array<char, hostname_dictionary::MAX_NAME_SIZE> & key, size_t & key_size ) {
+			std::array<char, hostname_dictionary::MAX_NAME_SIZE + 1> ace;
+			size_t size = 0;
+			try {
+				size = daw::to_puny_code( hostname, ace.data( ), ace.size( ) );
+			} catch( std::exception const & ) {
+				return false;
+			}
+			if( size > 0 && size <= ace.size( ) && ace[size - 1] == '.' ) {
+				--size;
+			}
+			if( size > hostname_dictionary::MAX_NAME_SIZE ) {
+				return false;
+			}
+			// Empty labels, '\0' which separates labels in a key, and non-ASCII bytes cannot be represented
+			daw::string_view const name{ ace.data( ), size };
+			if( name.empty( ) || name.front( ) == '.' || name.back( ) == '.' ||
+			    std::adjacent_find( name.begin( ), name.end( ), []( char a, char b ) { return a == '.' && b == '.'; } ) != name.end( ) ||
+			    std::any_of( name.begin( ), name.end( ), []( char c ) { return c == '\0' || static_cast<unsigned char>( c ) >= 0x80; } ) ) {
+				return false;
+			}
+			key_size = to_key( daw::string_view{ ace.data( ), size }, key.data( ) );
+			return true;
+		}
+	}    // namespace anonymous
+
+	struct hostname_dictionary::impl {
+		boost::iostreams::mapped_file_source file;
+		dictionary_header const * header;
+		restart_point const * restarts;
+		char const * data;
+		// Excludes the padding
+		char const * data_end;
+
+		// The first rank whose key is not less than key, found is set when that key is equal to it
+		size_t lower_bound( daw::string_view key, bool & found ) const noexcept {
+			found = false;
+			// The last block whose first key is not greater than key
+			size_t lo = 0;
+			size_t hi = header->block_count;
+			size_t matched = 0;
+			auto const prefix = key_prefix( key );
+			while( lo < hi ) {
+				auto const mid = lo + ( hi - lo ) / 2;
+				auto const & restart = restarts[mid];
+				if( restart.prefix != prefix ) {
+					if( restart.prefix < prefix ) {
+						lo = mid + 1;
+					} else {
+						hi = mid;
+					}
+					continue;
+				}
+				auto pos = data + restart.offset;
+				if( compare_run( pos, key, 0, matched ) <= 0 ) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			if( lo == 0 ) {
+				return 0;
+			}
+			auto const block = lo - 1;
+			auto const first_rank = block * header->block_size;
+			auto const last_rank = std::min<size_t>( first_rank + header->block_size, header->entry_count );
+			auto pos = data + restarts[block].offset;
+			auto order = compare_run( pos, key, 0, matched );
+			for( auto rank = first_rank;; ) {
+				if( order >= 0 ) {
+					found = order == 0;
+					return rank;
+				}
+				if( ++rank == last_rank ) {
+					return last_rank;
+				}
+				// A corrupt file can claim more keys than the block holds.  A key needs its shared byte and a run
+				if( data_end - pos < 2 ) {
+					return rank;
+				}
+				// Each key is greater than the one before and differs from it first at shared.  Less than matched
+				// means it is greater than key there, more than matched means it is still less than key
+				size_t const shared = static_cast<unsigned char>( *pos++ );
+				if( shared < matched ) {
+					return rank;
+				} else if( shared > matched ) {
+					skip_run( pos );
+				} else {
+					order = compare_run( pos, key, shared, matched );
+				}
+			}
+		}
+	};
+
+	hostname_dictionary::const_iterator::const_iterator( impl const * i, size_t rank ) noexcept
+	  : m_impl( i ), m_rank( rank ), m_next( nullptr ), m_key_size( 0 ), m_name_size( 0 ) {
+		if( m_rank >= m_impl->header->entry_count ) {
+			m_rank = m_impl->header->entry_count;
+			return;
+		}
+		// Decode from the start of the block up to rank
+		auto const block_size = m_impl->header->block_size;
+		auto const target = m_rank;
+		m_rank = ( target / block_size ) * block_size;
+		m_next = m_impl->data + m_impl->restarts[target / block_size].offset;
+		bool loaded = load( );
+		while( loaded && m_rank < target ) {
+			++m_rank;
+			loaded = load( );
+		}
+		if( !loaded ) {
+			// A corrupt file ends where it stops making sense
+			m_rank = m_impl->header->entry_count;
+		}
+	}
+
+	bool hostname_dictionary::const_iterator::load( ) noexcept {
+		size_t shared = 0;
+		if( m_rank % m_impl->header->block_size == 0 ) {
+			m_next = m_impl->data + m_impl->restarts[m_rank / m_impl->header->block_size].offset;
+		} else {
+			if( m_next == m_impl->data_end ) {
+				return false;
+			}
+			shared = static_cast<uint8_t>( *m_next++ );
+			if( shared > m_key_size ) {
+				return false;
+			}
+		}
+		auto const run = read_run( m_next, m_impl->data_end, m_key.data( ) + shared, m_key.size( ) - shared );
+		if( run == 0 ) {
+			return false;
+		}
+		m_key_size = static_cast<uint8_t>( shared + run );
+		m_name_size = static_cast<uint8_t>( to_name( daw::string_view{ m_key.data( ), m_key_size }, m_name.data( ) ) );
+		return true;
+	}
+
+	hostname_dictionary::const_iterator & hostname_dictionary::const_iterator::operator++( ) {
+		if( ++m_rank < m_impl->header->entry_count && !load( ) ) {
+			m_rank = m_impl->header->entry_count;
+		}
+		return *this;
+	}
+
+	hostname_dictionary::hostname_dictionary( std::shared_ptr<impl const> i ) noexcept : m_impl( std::move( i ) ) {}
+
+	hostname_dictionary hostname_dictionary::open( std::string const & path ) {
+		auto result = std::make_shared<impl>( );
+		result->file.open( path );
+		auto const data = result->file.data( );
+		auto const size = result->file.size( );
+		if( size < sizeof( dictionary_header ) ) {
+			throw std::runtime_error( path + " is not a hostname dictionary" );
+		}
+		result->header = reinterpret_cast<dictionary_header const *>( data );
+		auto const & header = *result->header;
+		if( !std::equal( std::begin( MAGIC ), std::end( MAGIC ), header.magic ) || header.version != VERSION ||
+		    header.byte_order != ENDIAN_MARKER ) {
+			throw std::runtime_error( path + " is not a compatible hostname dictionary" );
+		}
+		// Written so that no sum can overflow
+		if( header.file_size != size || header.block_size == 0 ||
+		    header.block_count != header.entry_count / header.block_size + ( header.entry_count % header.block_size != 0 ? 1 : 0 ) ||
+		    header.block_count > size / sizeof( restart_point ) || header.restarts_offset > size ||
+		    header.block_count * sizeof( restart_point ) > size - header.restarts_offset ||
+		    header.restarts_offset % alignof( restart_point ) != 0 || header.data_offset > size ||
+		    size - header.data_offset < RUN_PADDING ) {
+			throw std::runtime_error( path + " is truncated or corrupt" );
+		}
+		result->restarts = reinterpret_cast<restart_point const *>( data + header.restarts_offset );
+		result->data = data + header.data_offset;
+		auto const data_size = size - header.data_offset - RUN_PADDING;
+		result->data_end = result->data + data_size;
+		// Every run ends inside the data section, see RUN_PADDING
+		if( header.entry_count > 0 &&
+		    ( data_size == 0 || ( static_cast<unsigned char>( result->data_end[-1] ) & 0x80u ) == 0 ) ) {
+			throw std::runtime_error( path + " is truncated or corrupt" );
+		}
+		for( size_t block = 0; block < header.block_count; ++block ) {
+			if( result->restarts[block].offset >= data_size ) {
+				throw std::runtime_error( path + " is truncated or corrupt" );
+			}
+		}
+		return hostname_dictionary( std::move( result ) );
+	}
+
+	bool hostname_dictionary::verify( ) const {
+		auto const data = m_impl->file.data( );
+		return checksum( data + sizeof( dictionary_header ), data + m_impl->file.size( ) ) == m_impl->header->checksum;
+	}
+
+	size_t hostname_dictionary::size( ) const noexcept {
+		return static_cast<size_t>( m_impl->header->entry_count );
+	}
+
+	size_t hostname_dictionary::size_bytes( ) const noexcept {
+		return m_impl->file.size( );
+	}
+
+	std::string hostname_dictionary::at( size_t rank ) const {
+		if( rank >= size( ) ) {
+			throw std::out_of_range( "rank is past the end of the dictionary" );
+		}
+		const_iterator const it( m_impl.get( ), rank );
+		if( it.rank( ) != rank ) {
+			throw std::runtime_error( "The dictionary is corrupt" );
+		}
+		return ( *it ).to_string( );
+	}
+
+	size_t hostname_dictionary::rank( daw::string_view ace ) const noexcept {
+		if( ace.size( ) > MAX_NAME_SIZE ) {
+			return size( );
+		}
+		std::array<char, MAX_NAME_SIZE> key;
+		daw::string_view const probe{ key.data( ), to_key( ace, key.data( ) ) };
+		bool found = false;
+		auto const result = m_impl->lower_bound( probe, found );
+		return found ? result : size( );
+	}
+
+	bool hostname_dictionary::find( daw::string_view hostname, size_t & rank ) const {
+		std::array<char, MAX_NAME_SIZE> key;
+		size_t key_size = 0;
+		if( !make_key( hostname, key, key_size ) ) {
+			return false;
+		}
+		bool found = false;
+		rank = m_impl->lower_bound( daw::string_view{ key.data( ), key_size }, found );
+		return found;
+	}
+
+	bool hostname_dictionary::contains( daw::string_view hostname ) const {
+		size_t rank = 0;
+		return find( hostname, rank );
+	}
+
+	hostname_dictionary::const_iterator hostname_dictionary::begin( ) const noexcept {
+		return const_iterator( m_impl.get( ), 0 );
+	}
+
+	hostname_dictionary::const_iterator hostname_dictionary::end( ) const noexcept {
+		return const_iterator( m_impl.get( ), size( ) );
+	}
+
+	std::pair<hostname_dictionary::const_iterator, hostname_dictionary::const_iterator>
+	hostname_dictionary::suffix_range( daw::string_view zone ) const {
+		if( zone.empty( ) ) {
+			return { begin( ), end( ) };
+		}
+		std::array<char, MAX_NAME_SIZE> key;
+		size_t key_size = 0;
+		if( !make_key( zone, key, key_size ) ) {
+			return { end( ), end( ) };
+		}
+		// The zone's own key, then its subdomains which continue with '\0', then anything greater
+		bool found = false;
+		auto const first = m_impl->lower_bound( daw::string_view{ key.data( ), key_size }, found );
+		std::array<char, MAX_NAME_SIZE + 1> after;
+		std::copy( key.begin( ), key.begin( ) + static_cast<std::ptrdiff_t>( key_size ), after.begin( ) );
+		after[key_size] = '\x01';
+		auto const last = m_impl->lower_bound( daw::string_view{ after.data( ), key_size + 1 }, found );
+		return { const_iterator( m_impl.get( ), first ), const_iterator( m_impl.get( ), last ) };
+	}
+
+	void write_hostname_dictionary( std::vector<std::string> const & hostnames, std::string const & path ) {
+		std::vector<std::string> keys;
+		keys.reserve( hostnames.size( ) );
+		std::array<char, hostname_dictionary::MAX_NAME_SIZE> key;
+		for( auto const & host : hostnames ) {
+			size_t key_size = 0;
+			if( make_key( host, key, key_size ) ) {
+				keys.emplace_back( key.data( ), key_size );
+			}
+		}
+		std::sort( keys.begin( ), keys.end( ) );
+		keys.erase( std::unique( keys.begin( ), keys.end( ) ), keys.end( ) );
+
+		auto const block_size = hostname_dictionary::BLOCK_SIZE;
+		std::vector<restart_point> restarts;
+		std::string data;
+		for( size_t n = 0; n < keys.size( ); ++n ) {
+			auto const & current = keys[n];
+			if( n % block_size == 0 ) {
+				restarts.push_back( restart_point{ data.size( ), key_prefix( current ) } );
+				append_run( data, current, 0 );
+				continue;
+			}
+			auto const & previous = keys[n - 1];
+			auto const shared = static_cast<size_t>(
+			  std::mismatch( previous.begin( ), previous.begin( ) + static_cast<std::ptrdiff_t>( std::min( previous.size( ), current.size( ) ) ),
+			                 current.begin( ) ).first - previous.begin( ) );
+			// Keys are distinct and sorted, so none is a prefix of the one before and the rest is never empty
+			data += static_cast<char>( shared );
+			append_run( data, current, shared );
+		}
+
+		dictionary_header header;
+		std::memset( &header, 0, sizeof( header ) );
+		std::copy( std::begin( MAGIC ), std::end( MAGIC ), header.magic );
+		header.version = VERSION;
+		header.byte_order = ENDIAN_MARKER;
+		header.entry_count = keys.size( );
+		header.block_size = block_size;
+		header.block_count = restarts.size( );
+		header.restarts_offset = sizeof( dictionary_header );
+		header.data_offset = header.restarts_offset + restarts.size( ) * sizeof( restart_point );
+		data.append( RUN_PADDING, '\0' );
+		header.file_size = header.data_offset + data.size( );
+
+		std::string payload;
+		payload.reserve( header.file_size - sizeof( dictionary_header ) );
+		payload.append( reinterpret_cast<char const *>( restarts.data( ) ), restarts.size( ) * sizeof( restart_point ) );
+		payload += data;
+		header.checksum = checksum( payload.data( ), payload.data( ) + payload.size( ) );
+
+		std::ofstream out( path, std::ios::binary | std::ios::trunc );
+		out.write( reinterpret_cast<char const *>( &header ), sizeof( header ) );
+		out.write( payload.data( ), static_cast<std::streamsize>( payload.size( ) ) );
+		if( !out ) {
+			throw std::runtime_error( "Could not write " + path );
+		}
+	}
+}    // namespace daw
@@ -0,0 +1,271 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_filter.h"
+
+namespace daw {
+	namespace {
+		constexpr char const MAGIC[8] = { 'P', 'U', 'N', 'Y', 'X', 'O', 'R', '1' };
+		constexpr uint32_t const VERSION = 1;
+		constexpr uint32_t const ENDIAN_MARKER = 0x01020304;
+		constexpr size_t const MAX_ATTEMPTS = 64;
+
+		struct filter_header {
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order;
+			uint64_t seed;
+			uint64_t block_length;
+			uint64_t key_count;
+		};
+		static_assert( sizeof( filter_header ) == 40, "Unexpected header layout" );
+
+		constexpr uint64_t mix( uint64_t h ) noexcept {
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		// Works on 8 bytes at a time.  Setting bit 5 of every byte lower cases letters and leaves digits, '-' and '.'
+		// unchanged, so this is case insensitive for LDH names
+		uint64_t hash_ace( daw::string_view ace, uint64_t seed ) noexcept {
+			constexpr uint64_t const fold = 0x2020202020202020ULL;
+			auto h = seed ^ ( ace.size( ) * 0x9E3779B97F4A7C15ULL );
+			auto p = ace.data( );
+			auto remaining = ace.size( );
+			for( ; remaining >= 8; p += 8, remaining -= 8 ) {
+				uint64_t word;
+				std::memcpy( &word, p, 8 );
+				h = ( h ^ ( word | fold ) ) * 0x9E3779B97F4A7C15ULL;
+				h ^= h >> 29;
+			}
+			if( remaining > 0 ) {
+				uint64_t word = 0;
+				std::memcpy( &word, p, remaining );
+				auto const tail_fold = fold >> ( 8 * ( 8 - remaining ) );
+				h = ( h ^ ( word | tail_fold ) ) * 0x9E3779B97F4A7C15ULL;
+			}
+			return mix( h );
+		}
+
+		constexpr uint8_t fingerprint( uint64_t h ) noexcept {
+			return static_cast<uint8_t>( h ^ ( h >> 32 ) );
+		}
+
+		constexpr uint64_t rotl( uint64_t n, unsigned c ) noexcept {
+			return ( n << ( c & 63u ) ) | ( n >> ( ( 64u - c ) & 63u ) );
+		}
+
+		// Maps a hash onto [0, n) without a division
+		constexpr uint64_t reduce( uint32_t h, uint64_t n ) noexcept {
+			return ( static_cast<uint64_t>( h ) * n ) >> 32;
+		}
+
+		struct slots_t {
+			uint64_t h0;
+			uint64_t h1;
+			uint64_t h2;
+		};
+
+		constexpr slots_t slots_of( uint64_t h, uint64_t block_length ) noexcept {
+			return { reduce( static_cast<uint32_t>( h ), block_length ),
+			         reduce( static_cast<uint32_t>( rotl( h, 21 ) ), block_length ) + block_length,
+			         reduce( static_cast<uint32_t>( rotl( h, 42 ) ), block_length ) + 2 * block_length };
+		}
+
+		std::string ace_form( std::string const & hostname ) {
+			auto result = daw::to_puny_code( hostname );
+			if( !result.empty( ) && result.back( ) == '.' ) {
+				result.pop_back( );
+			}
+			return result;
+		}
+	}    // namespace anonymous
+
+	idn_filter idn_filter::build( std::vector<std::string> const & hostnames ) {
+		std::vector<std::string> keys;
+		keys.reserve( hostnames.size( ) );
+		for( auto const & host : hostnames ) {
+			if( !host.empty( ) ) {
+				keys.push_back( ace_form( host ) );
+			}
+		}
+		for( auto & key : keys ) {
+			for( auto & c : key ) {
+				c = static_cast<char>( c | 0x20 );
+			}
+		}
+		std::sort( keys.begin( ), keys.end( ) );
+		keys.erase( std::unique( keys.begin( ), keys.end( ) ), keys.end( ) );
+
+		auto const capacity = 32 + ( 123 * keys.size( ) ) / 100;
+		auto const block_length = capacity / 3 + 1;
+		auto const slot_count = 3 * block_length;
+		auto fingerprints = std::make_shared<std::vector<uint8_t>>( slot_count, 0 );
+
+		std::vector<uint64_t> hashes( keys.size( ) );
+		std::vector<uint32_t> counts( slot_count );
+		std::vector<uint64_t> xors( slot_count );
+		std::vector<uint64_t> queue;
+		std::vector<std::pair<uint64_t, uint64_t>> stack; // hash, slot
+		queue.reserve( slot_count );
+		stack.reserve( keys.size( ) );
+
+		uint64_t seed = 0x243F6A8885A308D3ULL;
+		for( size_t attempt = 0;; ++attempt, seed = mix( seed + attempt ) ) {
+			if( attempt == MAX_ATTEMPTS ) {
+				throw std::runtime_error( "Could not construct the filter, are there duplicate keys?" );
+			}
+			std::fill( counts.begin( ), counts.end( ), 0 );
+			std::fill( xors.begin( ), xors.end( ), 0 );
+			for( size_t n = 0; n < keys.size( ); ++n ) {
+				auto const h = hash_ace( keys[n], seed );
+				hashes[n] = h;
+				auto const s = slots_of( h, block_length );
+				for( auto slot : { s.h0, s.h1, s.h2 } ) {
+					++counts[slot];
+					xors[slot] ^= h;
+				}
+			}
+			// Peel slots that only one key maps to
+			queue.clear( );
+			stack.clear( );
+			for( uint64_t slot = 0; slot < slot_count; ++slot ) {
+				if( counts[slot] == 1 ) {
+					queue.push_back( slot );
+				}
+			}
+			while( !queue.empty( ) ) {
+				auto const slot = queue.back( );
+				queue.pop_back( );
+				if( counts[slot] != 1 ) {
+					continue;
+				}
+				auto const h = xors[slot];
+				stack.emplace_back( h, slot );
+				auto const s = slots_of( h, block_length );
+				for( auto other : { s.h0, s.h1, s.h2 } ) {
+					xors[other] ^= h;
+					if( --counts[other] == 1 ) {
+						queue.push_back( other );
+					}
+				}
+			}
+			if( stack.size( ) == keys.size( ) ) {
+				break;
+			}
+		}
+
+		auto & fp = *fingerprints;
+		for( auto it = stack.rbegin( ); it != stack.rend( ); ++it ) {
+			auto const h = it->first;
+			auto const s = slots_of( h, block_length );
+			fp[it->second] = 0;
+			fp[it->second] = static_cast<uint8_t>( fingerprint( h ) ^ fp[s.h0] ^ fp[s.h1] ^ fp[s.h2] );
+		}
+
+		idn_filter result;
+		result.m_seed = seed;
+		result.m_block_length = block_length;
+		result.m_key_count = keys.size( );
+		result.m_fingerprints = fp.data( );
+		result.m_storage = std::move( fingerprints );
+		return result;
+	}
+
+	idn_filter idn_filter::open( std::string const & path ) {
+		auto file = std::make_shared<boost::iostreams::mapped_file_source>( path );
+		if( file->size( ) < sizeof( filter_header ) ) {
+			throw std::runtime_error( path + " is not an IDN filter" );
+		}
+		filter_header header;
+		std::memcpy( &header, file->data( ), sizeof( header ) );
+		if( !std::equal( std::begin( MAGIC ), std::end( MAGIC ), header.magic ) || header.version != VERSION ||
+		    header.byte_order != ENDIAN_MARKER ) {
+			throw std::runtime_error( path + " is not a compatible IDN filter" );
+		}
+		if( file->size( ) != sizeof( filter_header ) + 3 * header.block_length || header.block_length == 0 ) {
+			throw std::runtime_error( path + " is truncated or corrupt" );
+		}
+		idn_filter result;
+		result.m_seed = header.seed;
+		result.m_block_length = header.block_length;
+		result.m_key_count = header.key_count;
+		result.m_fingerprints = reinterpret_cast<uint8_t const *>( file->data( ) + sizeof( filter_header ) );
+		result.m_storage = std::move( file );
+		return result;
+	}
+
+	void idn_filter::save( std::string const & path ) const {
+		filter_header header;
+		std::memset( &header, 0, sizeof( header ) );
+		std::copy( std::begin( MAGIC ), std::end( MAGIC ), header.magic );
+		header.version = VERSION;
+		header.byte_order = ENDIAN_MARKER;
+		header.seed = m_seed;
+		header.block_length = m_block_length;
+		header.key_count = m_key_count;
+		std::ofstream out( path, std::ios::binary | std::ios::trunc );
+		out.write( reinterpret_cast<char const *>( &header ), sizeof( header ) );
+		out.write( reinterpret_cast<char const *>( m_fingerprints ), static_cast<std::streamsize>( size_in_bytes( ) ) );
+		if( !out ) {
+			throw std::runtime_error( "Could not write " + path );
+		}
+	}
+
+	bool idn_filter::may_contain_ace( daw::string_view ace ) const noexcept {
+		if( m_block_length == 0 ) {
+			return false;
+		}
+		if( !ace.empty( ) && ace.back( ) == '.' ) {
+			ace.remove_suffix( 1 );
+		}
+		auto const h = hash_ace( ace, m_seed );
+		auto const s = slots_of( h, m_block_length );
+		return fingerprint( h ) == ( m_fingerprints[s.h0] ^ m_fingerprints[s.h1] ^ m_fingerprints[s.h2] );
+	}
+
+	bool idn_filter::may_contain( daw::string_view hostname ) const {
+		auto const ascii = std::all_of( hostname.begin( ), hostname.end( ), []( char c ) {
+			return static_cast<unsigned char>( c ) < 128;
+		} );
+		if( ascii ) {
+			return may_contain_ace( hostname );
+		}
+		auto const ace = daw::to_puny_code( hostname );
+		return may_contain_ace( ace );
+	}
+}    // namespace daw
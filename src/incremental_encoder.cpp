@@ -0,0 +1,212 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_impl.h"
+#include "puny_coder_incremental.h"
+#include "puny_coder_labels.h"
+
+namespace daw {
+	namespace {
+		size_t utf8_size( uint32_t cp ) noexcept {
+			return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+		}
+	}    // namespace anonymous
+
+	incremental_encoder::incremental_encoder( )
+	  : m_labels{ label_t{ 0, 0, 0, 0, 0 } }
+	  , m_encoded( 0 )
+	  , m_labels_encoded( 0 )
+	  , m_state_first( 0 )
+	  , m_state_decoded( 0 )
+	  , m_state_valid( 0 ) { }
+
+	incremental_encoder::incremental_encoder( daw::string_view text ) : incremental_encoder( ) {
+		append( text );
+	}
+
+	void incremental_encoder::append( daw::string_view text ) {
+		auto const unchanged = m_text.size( );
+		m_text.append( text.data( ), text.size( ) );
+		edited( unchanged );
+	}
+
+	void incremental_encoder::pop_back( ) {
+		if( m_text.empty( ) ) {
+			return;
+		}
+		auto size = m_text.size( ) - 1;
+		while( size > 0 && m_text.size( ) - size < 4 && ( static_cast<unsigned char>( m_text[size] ) & 0xC0u ) == 0x80u ) {
+			--size;
+		}
+		uint32_t cp = 0;
+		auto first = m_text.data( ) + size;
+		if( !impl::decode_utf8( first, m_text.data( ) + m_text.size( ), cp ) || first != m_text.data( ) + m_text.size( ) ) {
+			size = m_text.size( ) - 1;
+		}
+		m_text.resize( size );
+		edited( size );
+	}
+
+	void incremental_encoder::assign( daw::string_view text ) {
+		auto const common = std::min( m_text.size( ), text.size( ) );
+		auto const unchanged = static_cast<size_t>( std::mismatch( m_text.begin( ), m_text.begin( ) + static_cast<std::ptrdiff_t>( common ), text.begin( ) ).first - m_text.begin( ) );
+		m_text.assign( text.data( ), text.size( ) );
+		edited( unchanged );
+	}
+
+	void incremental_encoder::clear( ) {
+		assign( daw::string_view{ } );
+	}
+
+	void incremental_encoder::split( size_t first ) {
+		auto const host = text( );
+		while( true ) {
+			auto const separator = find_label_separator( host, first );
+			auto const separator_size = separator == host.size( ) ? 0 : label_separator_size( host, separator );
+			m_labels.push_back( label_t{ first, separator - first, separator_size, 0, 0 } );
+			if( separator_size == 0 ) {
+				return;
+			}
+			first = separator + separator_size;
+		}
+	}
+
+	void incremental_encoder::edited( size_t unchanged ) {
+		// Labels that end, separator included, before the first changed byte are as they were.  The rest are split
+		// again, and the first of those may still turn out to be unchanged, as when a separator is typed after it
+		size_t kept = 0;
+		while( kept + 1 < m_labels.size( ) &&
+		       m_labels[kept].first + m_labels[kept].size + m_labels[kept].separator <= unchanged ) {
+			++kept;
+		}
+		auto const previous = m_labels[kept];
+		auto const was_encoded = kept < m_encoded;
+		m_labels.resize( kept );
+		split( previous.first );
+		m_encoded = std::min( m_encoded, kept );
+		auto & label = m_labels[kept];
+		if( was_encoded && label.size == previous.size && label.first + label.size <= unchanged ) {
+			label.ace_first = previous.ace_first;
+			label.ace_size = previous.ace_size;
+			m_encoded = kept + 1;
+		}
+		m_state_valid = unchanged < m_state_first ? 0 : std::min( m_state_valid, unchanged - m_state_first );
+	}
+
+	void incremental_encoder::push_code_point( uint32_t cp ) {
+		m_code_points.push_back( cp );
+		m_state_decoded += utf8_size( cp );
+		if( punycode_parameters::is_basic( cp ) ) {
+			m_basic.push_back( static_cast<char>( impl::to_lower( cp ) ) );
+			return;
+		}
+		auto const pos = std::lower_bound( m_distinct.begin( ), m_distinct.end( ), cp );
+		auto const index = static_cast<size_t>( pos - m_distinct.begin( ) );
+		if( pos != m_distinct.end( ) && *pos == cp ) {
+			++m_counts[index];
+			return;
+		}
+		m_distinct.insert( pos, cp );
+		m_counts.insert( m_counts.begin( ) + static_cast<std::ptrdiff_t>( index ), 1 );
+	}
+
+	void incremental_encoder::pop_code_point( ) {
+		auto const cp = m_code_points.back( );
+		m_code_points.pop_back( );
+		m_state_decoded -= utf8_size( cp );
+		if( punycode_parameters::is_basic( cp ) ) {
+			m_basic.pop_back( );
+			return;
+		}
+		auto const index = static_cast<size_t>( std::lower_bound( m_distinct.begin( ), m_distinct.end( ), cp ) - m_distinct.begin( ) );
+		if( --m_counts[index] == 0 ) {
+			m_distinct.erase( m_distinct.begin( ) + static_cast<std::ptrdiff_t>( index ) );
+			m_counts.erase( m_counts.begin( ) + static_cast<std::ptrdiff_t>( index ) );
+		}
+	}
+
+	void incremental_encoder::encode_last( label_t const & label ) {
+		if( label.first != m_state_first ) {
+			m_state_first = label.first;
+			m_state_valid = 0;
+		}
+		while( m_state_decoded > m_state_valid ) {
+			pop_code_point( );
+		}
+		auto first = m_text.data( ) + label.first + m_state_decoded;
+		auto const last = m_text.data( ) + label.first + label.size;
+		uint32_t cp = 0;
+		while( first != last && impl::decode_utf8( first, last, cp ) ) {
+			push_code_point( cp );
+		}
+		m_state_valid = m_state_decoded;
+		if( first != last ) {
+			// Not UTF-8, or not yet; left to to_puny_code so the result is the same
+			m_ace += to_puny_code( daw::string_view{ m_text.data( ) + label.first, label.size } );
+			return;
+		}
+		if( m_distinct.empty( ) ) {
+			m_ace += m_basic;
+			return;
+		}
+		m_ace.append( impl::constants::PREFIX.data( ), impl::constants::PREFIX.size( ) );
+		m_ace += m_basic;
+		if( !m_basic.empty( ) ) {
+			m_ace += punycode_parameters::DELIMITER;
+		}
+		punycode::encode_delta_section( m_code_points, m_basic.size( ), m_distinct.begin( ), m_distinct.end( ), m_ace );
+	}
+
+	daw::string_view incremental_encoder::ace( ) {
+		if( m_encoded == 0 ) {
+			m_ace.clear( );
+		} else {
+			auto const & encoded = m_labels[m_encoded - 1];
+			m_ace.resize( encoded.ace_first + encoded.ace_size );
+		}
+		for( ; m_encoded < m_labels.size( ); ++m_encoded ) {
+			auto & label = m_labels[m_encoded];
+			if( m_encoded > 0 ) {
+				m_ace += '.';
+			}
+			label.ace_first = m_ace.size( );
+			if( label.size > 0 ) {
+				if( m_encoded + 1 == m_labels.size( ) ) {
+					encode_last( label );
+				} else {
+					m_ace += to_puny_code( daw::string_view{ m_text.data( ) + label.first, label.size } );
+				}
+				++m_labels_encoded;
+			}
+			label.ace_size = m_ace.size( ) - label.ace_first;
+		}
+		return daw::string_view{ m_ace.data( ), m_ace.size( ) };
+	}
+}    // namespace daw
@@ -0,0 +1,137 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder_labels.h"
+
+namespace daw {
+	namespace {
+		// U+3002, U+FF0E and U+FF61 in UTF-8
+		constexpr unsigned char const FULL_STOPS[3][3] = { { 0xE3, 0x80, 0x82 }, { 0xEF, 0xBC, 0x8E }, { 0xEF, 0xBD, 0xA1 } };
+
+		bool is_full_stop( char const * p ) noexcept {
+			for( auto const & stop : FULL_STOPS ) {
+				if( static_cast<unsigned char>( p[0] ) == stop[0] && static_cast<unsigned char>( p[1] ) == stop[1] &&
+				    static_cast<unsigned char>( p[2] ) == stop[2] ) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		size_t lowest_bit( uint32_t mask ) noexcept {
+#if defined( __GNUC__ ) || defined( __clang__ )
+			return static_cast<size_t>( __builtin_ctz( mask ) );
+#else
+			size_t result = 0;
+			while( ( mask & 1 ) == 0 ) {
+				mask >>= 1;
+				++result;
+			}
+			return result;
+#endif
+		}
+
+		size_t highest_bit( uint32_t mask ) noexcept {
+#if defined( __GNUC__ ) || defined( __clang__ )
+			return static_cast<size_t>( 31 - __builtin_clz( mask ) );
+#else
+			size_t result = 31;
+			while( ( mask & ( 1u << result ) ) == 0 ) {
+				--result;
+			}
+			return result;
+#endif
+		}
+	}    // namespace anonymous
+
+	size_t label_separator_size( daw::string_view host, size_t position ) noexcept {
+		if( host[position] == '.' ) {
+			return 1;
+		} else if( position + 3 <= host.size( ) && is_full_stop( host.data( ) + position ) ) {
+			return 3;
+		}
+		return 0;
+	}
+
+	size_t find_label_separator( daw::string_view host, size_t first ) noexcept {
+		auto position = first;
+#ifdef __SSE2__
+		// A '.' or the lead byte of a full stop
+		for( ; position + 16 <= host.size( ); position += 16 ) {
+			auto const block = _mm_loadu_si128( reinterpret_cast<__m128i const *>( host.data( ) + position ) );
+			auto const candidates = _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( '.' ) ),
+			                                      _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( static_cast<char>( 0xE3 ) ) ),
+			                                                    _mm_cmpeq_epi8( block, _mm_set1_epi8( static_cast<char>( 0xEF ) ) ) ) );
+			for( auto mask = static_cast<uint32_t>( _mm_movemask_epi8( candidates ) ); mask != 0; mask &= mask - 1 ) {
+				auto const candidate = position + lowest_bit( mask );
+				if( label_separator_size( host, candidate ) != 0 ) {
+					return candidate;
+				}
+			}
+		}
+#endif
+		for( ; position < host.size( ); ++position ) {
+			if( label_separator_size( host, position ) != 0 ) {
+				return position;
+			}
+		}
+		return host.size( );
+	}
+
+	size_t rfind_label_separator( daw::string_view host, size_t last ) noexcept {
+		auto position = last;
+		// Checks for a separator whose final byte is at end - 1
+		auto const ends_separator = [&host]( size_t end ) {
+			return host[end - 1] == '.' || ( end >= 3 && is_full_stop( host.data( ) + end - 3 ) );
+		};
+#ifdef __SSE2__
+		// A '.' or the final byte of a full stop
+		for( ; position >= 16; position -= 16 ) {
+			auto const block = _mm_loadu_si128( reinterpret_cast<__m128i const *>( host.data( ) + position - 16 ) );
+			auto const candidates = _mm_or_si128(
+			  _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( '.' ) ), _mm_cmpeq_epi8( block, _mm_set1_epi8( static_cast<char>( 0x82 ) ) ) ),
+			  _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( static_cast<char>( 0x8E ) ) ), _mm_cmpeq_epi8( block, _mm_set1_epi8( static_cast<char>( 0xA1 ) ) ) ) );
+			for( auto mask = static_cast<uint32_t>( _mm_movemask_epi8( candidates ) ); mask != 0; mask &= ~( 1u << highest_bit( mask ) ) ) {
+				auto const end = position - 16 + highest_bit( mask ) + 1;
+				if( ends_separator( end ) ) {
+					return end;
+				}
+			}
+		}
+#endif
+		for( ; position > 0; --position ) {
+			if( ends_separator( position ) ) {
+				return position;
+			}
+		}
+		return 0;
+	}
+}    // namespace daw
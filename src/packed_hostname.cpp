@@ -0,0 +1,213 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_packed.h"
+
+namespace daw {
+	namespace {
+		constexpr uint8_t const INVALID_CODE = 0xFF;
+		constexpr char const CHARACTERS[] = "\0-.0123456789abcdefghijklmnopqrstuvwxyz";
+		constexpr uint8_t const CODE_COUNT = 39;
+
+		constexpr uint8_t to_code( char c ) noexcept {
+			return c == '-' || c == '.' ? static_cast<uint8_t>( c - 0x2C )
+			       : c >= '0' && c <= '9' ? static_cast<uint8_t>( c - 0x2D )
+			       : c >= 'a' && c <= 'z' ? static_cast<uint8_t>( c - 0x54 ) : INVALID_CODE;
+		}
+
+		static_assert( to_code( '-' ) == 1 && to_code( '.' ) == 2 && to_code( '0' ) == 3 && to_code( '9' ) == 12 &&
+		                 to_code( 'a' ) == 13 && to_code( 'z' ) == 38,
+		               "Codes must follow the character order" );
+
+		[[noreturn]] void invalid_character( char c ) {
+			throw std::runtime_error( std::string( "Cannot pack the character '" ) + c + "'" );
+		}
+
+#ifdef __SSSE3__
+		// Packs 16 characters into 12 bytes, false if any of them cannot be packed
+		bool pack_block( char const * first, uint8_t * out ) noexcept {
+			auto const block = _mm_loadu_si128( reinterpret_cast<__m128i const *>( first ) );
+			auto const in_range = [&block]( char low, char high ) {
+				return _mm_and_si128( _mm_cmpgt_epi8( block, _mm_set1_epi8( static_cast<char>( low - 1 ) ) ),
+				                      _mm_cmpgt_epi8( _mm_set1_epi8( static_cast<char>( high + 1 ) ), block ) );
+			};
+			auto const punctuation = in_range( '-', '.' );
+			auto const digits = in_range( '0', '9' );
+			auto const letters = in_range( 'a', 'z' );
+			auto const valid = _mm_or_si128( punctuation, _mm_or_si128( digits, letters ) );
+			if( _mm_movemask_epi8( valid ) != 0xFFFF ) {
+				return false;
+			}
+			auto const offsets = _mm_or_si128( _mm_and_si128( punctuation, _mm_set1_epi8( 0x2C ) ),
+			                                   _mm_or_si128( _mm_and_si128( digits, _mm_set1_epi8( 0x2D ) ),
+			                                                 _mm_and_si128( letters, _mm_set1_epi8( 0x54 ) ) ) );
+			auto const codes = _mm_sub_epi8( block, offsets );
+			// Pairs of codes to 12 bits, pairs of those to 24 bits in each 32 bit lane, then the three bytes of each
+			// lane most significant first
+			auto const pairs = _mm_maddubs_epi16( codes, _mm_set1_epi32( 0x01400140 ) );
+			auto const quads = _mm_madd_epi16( pairs, _mm_set1_epi32( 0x00011000 ) );
+			auto const packed = _mm_shuffle_epi8( quads, _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+			alignas( 16 ) std::array<uint8_t, 16> result;
+			_mm_store_si128( reinterpret_cast<__m128i *>( result.data( ) ), packed );
+			std::copy( result.begin( ), result.begin( ) + 12, out );
+			return true;
+		}
+#endif
+	}    // namespace anonymous
+
+	size_t pack_hostname( daw::string_view ace, uint8_t * out, size_t capacity ) {
+		auto const result = packed_size( ace.size( ) );
+		if( result > capacity ) {
+			// Still report bad input rather than a size that could never be packed
+			for( auto c : ace ) {
+				if( to_code( c ) == INVALID_CODE ) {
+					invalid_character( c );
+				}
+			}
+			return result;
+		}
+		size_t position = 0;
+#ifdef __SSSE3__
+		for( ; position + 16 <= ace.size( ); position += 16 ) {
+			if( !pack_block( ace.data( ) + position, out ) ) {
+				break;
+			}
+			out += 12;
+		}
+#endif
+		uint32_t bits = 0;
+		size_t bit_count = 0;
+		for( ; position < ace.size( ); ++position ) {
+			auto const code = to_code( ace[position] );
+			if( code == INVALID_CODE ) {
+				invalid_character( ace[position] );
+			}
+			bits = ( bits << 6u ) | code;
+			bit_count += 6;
+			if( bit_count >= 8 ) {
+				bit_count -= 8;
+				*out++ = static_cast<uint8_t>( bits >> bit_count );
+			}
+		}
+		if( bit_count > 0 ) {
+			*out = static_cast<uint8_t>( bits << ( 8 - bit_count ) );
+		}
+		return result;
+	}
+
+	size_t unpack_hostname( uint8_t const * packed, size_t size, char * out, size_t capacity ) {
+		auto const code_count = size * 8 / 6;
+		uint32_t bits = 0;
+		size_t bit_count = 0;
+		size_t result = 0;
+		for( size_t n = 0; n < size; ++n ) {
+			bits = ( bits << 8u ) | packed[n];
+			bit_count += 8;
+			while( bit_count >= 6 ) {
+				bit_count -= 6;
+				auto const code = ( bits >> bit_count ) & 0x3Fu;
+				if( code == 0 && result + 1 == code_count ) {
+					// The final code pads 4n + 3 characters to a whole byte
+					break;
+				}
+				if( code == 0 || code >= CODE_COUNT ) {
+					throw std::runtime_error( "Invalid packed hostname" );
+				}
+				if( result < capacity ) {
+					out[result] = CHARACTERS[code];
+				}
+				++result;
+			}
+		}
+		if( packed_size( result ) != size || ( bit_count > 0 && ( bits & ( ( 1u << bit_count ) - 1u ) ) != 0 ) ) {
+			throw std::runtime_error( "Invalid packed hostname" );
+		}
+		return result;
+	}
+
+	packed_hostname::packed_hostname( daw::string_view ace ) : m_data{ }, m_size( 0 ) {
+		if( ace.size( ) > MAX_SIZE ) {
+			throw std::runtime_error( "A hostname cannot be longer than 255 bytes" );
+		}
+		pack_hostname( ace, m_data.data( ), m_data.size( ) );
+		m_size = static_cast<uint8_t>( ace.size( ) );
+	}
+
+	packed_hostname packed_hostname::from_bytes( uint8_t const * packed, size_t size ) {
+		if( size > MAX_BYTES ) {
+			throw std::runtime_error( "Invalid packed hostname" );
+		}
+		std::array<char, MAX_SIZE + 1> text;
+		auto const characters = unpack_hostname( packed, size, text.data( ), text.size( ) );
+		if( characters > MAX_SIZE ) {
+			throw std::runtime_error( "A hostname cannot be longer than 255 bytes" );
+		}
+		packed_hostname result;
+		std::copy( packed, packed + size, result.m_data.begin( ) );
+		result.m_size = static_cast<uint8_t>( characters );
+		return result;
+	}
+
+	std::string packed_hostname::to_string( ) const {
+		std::string result( m_size, '\0' );
+		unpack_hostname( data( ), size_bytes( ), &result[0], result.size( ) );
+		return result;
+	}
+
+	hostname packed_hostname::to_hostname( ) const {
+		hostname result;
+		result.resize( unpack_hostname( data( ), size_bytes( ), result.data( ), hostname::MAX_SIZE ) );
+		return result;
+	}
+
+	packed_hostname to_puny_code_packed( daw::string_view input ) {
+		std::array<char, packed_hostname::MAX_SIZE> ace;
+		auto const size = to_puny_code( input, ace.data( ), ace.size( ) );
+		if( size > ace.size( ) ) {
+			throw std::runtime_error( "The converted hostname is longer than 255 bytes" );
+		}
+		return packed_hostname( daw::string_view{ ace.data( ), size } );
+	}
+
+	std::vector<packed_hostname> pack_hostnames( std::vector<daw::string_view> const & aces ) {
+		std::vector<packed_hostname> result;
+		result.reserve( aces.size( ) );
+		for( auto const & ace : aces ) {
+			result.emplace_back( ace );
+		}
+		return result;
+	}
+}    // namespace daw
@@ -21,264 +21,542 @@
 // SOFTWARE.
 //
 
+#include <array>
+#include <algorithm>
 #include <cstdint>
-#include <sstream>
+#include <limits>
+#include <mutex>
+#include <vector>
 
 #include <daw/char_range/daw_char_range.h>
 #include <daw/daw_parser_helper.h>
 #include <daw/daw_string_view.h>
 
 #include "puny_coder.h"
+#include "puny_coder_impl.h"
+#include "puny_coder_labels.h"
 
 namespace daw {
 	namespace {
-		namespace constants {
-			constexpr uint32_t const BASE = 36;
-			constexpr uint32_t const TMIN = 1;
-			constexpr uint32_t const TMAX = 26;
-			constexpr uint32_t const SKEW = 38;
-			constexpr uint32_t const DAMP = 700;
-			constexpr uint32_t const INITIAL_BIAS = 72;
-			constexpr uint32_t const INITIAL_N = 128;
-			constexpr daw::string_view const PREFIX = "xn--";
-			constexpr auto const DELIMITER = '-';
-		}; // namespace costants
-
-		template<typename CP>
-		constexpr auto to_lower( CP cp ) noexcept {
-			return cp | 32;
-		}
+		using namespace daw::impl;
 
-		template<typename T, typename U>
-		constexpr auto adapt( T delta, U n_points, bool is_first ) noexcept {
-			// scale back, then increase delta
-			delta /= is_first ? constants::DAMP : 2;
-			delta += delta / n_points;
+		// Writes up to capacity bytes and counts the rest, so a buffer that is too small still yields the size needed
+		class output_buffer {
+			char * m_first;
+			size_t m_capacity;
+			size_t m_size = 0;
 
-			auto const s = constants::BASE - constants::TMIN;
-			auto const t = (s * constants::TMAX)/2;
+		public:
+			output_buffer( char * first, size_t capacity ) noexcept : m_first( first ), m_capacity( capacity ) { }
 
-			uint32_t k = 0;
-			for( ; delta > t; k += constants::BASE ) {
-				delta /= s;
+			void push_back( char c ) noexcept {
+				if( m_size < m_capacity ) {
+					m_first[m_size] = c;
+				}
+				++m_size;
 			}
 
-			auto const a = (constants::BASE - constants::TMIN + 1) * delta;
-			auto const b = (delta + constants::SKEW);
+			void append( char const * first, size_t count ) noexcept {
+				if( m_size < m_capacity ) {
+					std::copy( first, first + std::min( count, m_capacity - m_size ), m_first + m_size );
+				}
+				m_size += count;
+			}
 
-			return k + (a / b);
-		}
+			void append( daw::string_view str ) noexcept {
+				append( str.data( ), str.size( ) );
+			}
 
+			size_t size( ) const noexcept {
+				return m_size;
+			}
 
-		template<typename Iterator>
-		auto sort_uniq( Iterator first, Iterator last ) {
-			using value_type = std::decay_t<decltype(*first)>;
-			std::vector<value_type> result;
-			std::copy( first, last, std::back_inserter( result ) );
-			std::sort( result.begin( ), result.end( ), std::greater<value_type>( ) );
-			auto new_end = std::unique( result.begin( ), result.end( ) );
-			result.erase( new_end, result.end( ) );
-			return result;
-		}
+			bool fits( ) const noexcept {
+				return m_size <= m_capacity;
+			}
 
+			// What was written from position on, only meaningful when fits( )
+			daw::string_view written_since( size_t position ) const noexcept {
+				return daw::string_view{ m_first + position, m_size - position };
+			}
+		};
 
-		template<typename T, typename U>
-		constexpr auto calculate_threshold( T k, U bias ) noexcept {
-			if( k <= bias + constants::TMIN ) {
-				return constants::TMIN;
-			} else if( k >= bias + constants::TMAX ) {
-				return constants::TMAX;
+		template<typename Iterator>
+		constexpr bool is_ascii( Iterator first, Iterator last ) noexcept {
+			for( ; first != last; ++first ) {
+				if( static_cast<unsigned char>( *first ) >= 128 ) {
+					return false;
+				}
 			}
-			return k - bias;
+			return true;
 		}
 
-		template<typename T>
-		constexpr char encode_digit( T d ) noexcept {
-			if( d < 26 ) {
-				return static_cast<char>(d) + 97;
+		// The label is decoded again for each Bootstring pass so no allocation is needed
+		void encode_part( daw::string_view label, output_buffer & output ) {
+			if( is_ascii( label.begin( ), label.end( ) ) ) {
+				for( auto c : label ) {
+					output.push_back( static_cast<char>( to_lower( c ) ) );
+				}
+				return;
 			}
-			return static_cast<char>(d) + 22;
+			output.append( constants::PREFIX );
+			punycode::encode( daw::range::create_char_range( label.begin( ), label.end( ) ), output, []( uint32_t c ) {
+				return static_cast<char>( to_lower( c ) );
+			} );
 		}
 
-		template<typename T, typename U>
-		auto encode_int( T bias, U delta ) {
-			std::string result;
-		
-			auto k = constants::BASE;
-			auto q = delta;
-
-			while( true ) {
-				auto t = calculate_threshold( k, bias );
-				if( q < t ) {
-					result += encode_digit( q );
-					break;
-				} else {
-					result += encode_digit( t + ((q - t) % (constants::BASE - t)) );
-					q = (q - t)/(constants::BASE - t);
-				
-				}
-				k += constants::BASE;
+		constexpr size_t const MAX_LABEL_SIZE = 63;
+
+		void decode_part( daw::string_view label, output_buffer & output ) {
+			auto u8input = daw::range::create_char_range( label.begin( ), label.end( ) );
+			auto const size = u8input.size( );
+			if( size < 1 || size > MAX_LABEL_SIZE ) {
+				throw std::runtime_error( "The size of the part must be between 1 and 63 inclusive" );
+			}
+			if( !begins_with_prefix( u8input ) ) {
+				output.append( label );
+				return;
+			} else {
+				u8input.advance( constants::PREFIX.size( ) );
+			}
+			std::array<uint32_t, MAX_LABEL_SIZE> input;
+			size_t input_size = 0;
+			for( auto c : u8input ) {
+				input[input_size++] = c;
 			}
 
-			return result;
+			// Every code point consumes at least one input character so the output is never longer than the input
+			std::array<uint32_t, MAX_LABEL_SIZE> decoded;
+			auto const decoded_size = punycode::decode( input.data( ), input.data( ) + input_size, decoded.data( ), decoded.size( ) );
+			for( size_t k = 0; k < decoded_size; ++k ) {
+				append_utf8( output, decoded[k] );
+			}
 		}
 
-		std::string encode_part( daw::range::CharRange input ) {
-			std::string output;
-			std::vector<uint32_t> non_basic;
-			
-			for( auto c : input ) {
-				if( c < 128 ) {
-					output += static_cast<char>( to_lower( c ) );
-				} else {
-					non_basic.push_back( c );
+		class label_cache {
+			static constexpr size_t const SHARD_COUNT = 16;
+			static constexpr size_t const WAYS = 4;
+			static constexpr size_t const SKETCH_ROWS = 4;
+			static constexpr uint8_t const SKETCH_MAX = 15;
+
+		public:
+			static constexpr size_t const MAX_KEY_SIZE = 64;
+			static constexpr size_t const MAX_VALUE_SIZE = 64;
+			static constexpr size_t const DEFAULT_CAPACITY = 4096;
+
+		private:
+			struct entry_t {
+				uint64_t hash = 0;
+				uint8_t key_size = 0;
+				uint8_t value_size = 0;
+				std::array<char, MAX_KEY_SIZE> key;
+				std::array<char, MAX_VALUE_SIZE> value;
+
+				bool matches( uint64_t h, daw::string_view k ) const noexcept {
+					return hash == h && key_size == k.size( ) && std::equal( k.begin( ), k.end( ), key.begin( ) );
 				}
-			}
+			};
 
-			if( non_basic.empty( ) ) {
-				return output;
-			}
+			struct shard_t {
+				std::mutex mutex;
+				std::vector<entry_t> entries;
+				std::vector<uint8_t> sketch;
+				size_t sketch_additions = 0;
+				label_cache_stats stats;
 
+				size_t bucket_count( ) const noexcept {
+					return entries.size( ) / WAYS;
+				}
 
-			auto b = output.size( );
-			auto h = b;
+				size_t sketch_index( uint64_t h, size_t row ) const noexcept {
+					auto const width = sketch.size( ) / SKETCH_ROWS;
+					auto const rh = (h >> (row * 16)) ^ (h >> 48) * (row + 1);
+					return row * width + (rh & (width - 1));
+				}
 
-			if( !output.empty( )) {
-				output += constants::DELIMITER;
+				uint8_t frequency( uint64_t h ) const noexcept {
+					uint8_t result = SKETCH_MAX;
+					for( size_t row = 0; row < SKETCH_ROWS; ++row ) {
+						result = std::min( result, sketch[sketch_index( h, row )] );
+					}
+					return result;
+				}
+
+				void record_access( uint64_t h ) noexcept {
+					for( size_t row = 0; row < SKETCH_ROWS; ++row ) {
+						auto & counter = sketch[sketch_index( h, row )];
+						if( counter < SKETCH_MAX ) {
+							++counter;
+						}
+					}
+					// Age the sketch so old popularity decays
+					if( ++sketch_additions >= 10 * entries.size( ) ) {
+						for( auto & counter : sketch ) {
+							counter /= 2;
+						}
+						sketch_additions = 0;
+					}
+				}
+
+				void resize( size_t slots ) {
+					entries.clear( );
+					entries.resize( slots );
+					size_t width = 64;
+					while( width < 2 * slots ) {
+						width *= 2;
+					}
+					sketch.assign( slots == 0 ? 0 : SKETCH_ROWS * width, 0 );
+					sketch_additions = 0;
+				}
+			};
+
+			std::array<shard_t, SHARD_COUNT> m_shards;
+
+			static uint64_t hash( daw::string_view key ) noexcept {
+				// FNV-1a
+				uint64_t result = 14695981039346656037ULL;
+				for( auto c : key ) {
+					result ^= static_cast<unsigned char>( c );
+					result *= 1099511628211ULL;
+				}
+				return result == 0 ? 1 : result;
 			}
 
-			auto n = constants::INITIAL_N;
-			auto bias = constants::INITIAL_BIAS;
-			uint32_t delta = 0;
+			shard_t & shard_for( uint64_t h ) noexcept {
+				return m_shards[(h >> 59) % SHARD_COUNT];
+			}
+
+		public:
+			explicit label_cache( size_t capacity ) {
+				set_capacity( capacity );
+			}
 
-			non_basic = sort_uniq( non_basic.begin( ), non_basic.end( ) );
+			void set_capacity( size_t capacity ) {
+				auto per_shard = (capacity + SHARD_COUNT - 1) / SHARD_COUNT;
+				per_shard = ((per_shard + WAYS - 1) / WAYS) * WAYS;
+				for( auto & shard : m_shards ) {
+					std::lock_guard<std::mutex> lock( shard.mutex );
+					shard.resize( per_shard );
+				}
+			}
 
-			for( auto len = input.size( ); h < len; ++n, ++delta ) {
-				auto m = non_basic.back( );
-				non_basic.pop_back( );
+			void clear( ) {
+				for( auto & shard : m_shards ) {
+					std::lock_guard<std::mutex> lock( shard.mutex );
+					shard.resize( shard.entries.size( ) );
+					shard.stats = label_cache_stats{ };
+				}
+			}
 
-				delta += (m - n) * (h + 1);
-				n = m;
+			label_cache_stats stats( ) {
+				label_cache_stats result{ };
+				for( auto & shard : m_shards ) {
+					std::lock_guard<std::mutex> lock( shard.mutex );
+					result.hits += shard.stats.hits;
+					result.misses += shard.stats.misses;
+					result.admitted += shard.stats.admitted;
+					result.rejected += shard.stats.rejected;
+					result.capacity += shard.entries.size( );
+				}
+				return result;
+			}
 
-				for( auto it = input.begin( ); it != (input.begin( ) + len); ++it ) {
-					if( *it < n && ++delta == 0 ) {
-						throw std::runtime_error( "delta overflow" );
-					} else if( *it == n ) {
-						output += encode_int( bias, delta );
-						bias = adapt( delta, h + 1, b == h );
-						delta = 0;
-						++h;
+			bool lookup( daw::string_view key, output_buffer & value ) {
+				if( key.size( ) > MAX_KEY_SIZE ) {
+					return false;
+				}
+				auto const h = hash( key );
+				auto & shard = shard_for( h );
+				std::lock_guard<std::mutex> lock( shard.mutex );
+				if( shard.entries.empty( ) ) {
+					return false;
+				}
+				shard.record_access( h );
+				auto const first = (h % shard.bucket_count( )) * WAYS;
+				for( size_t n = first; n < first + WAYS; ++n ) {
+					auto const & entry = shard.entries[n];
+					if( entry.matches( h, key ) ) {
+						value.append( entry.value.data( ), entry.value_size );
+						++shard.stats.hits;
+						return true;
 					}
 				}
+				++shard.stats.misses;
+				return false;
 			}
-			return constants::PREFIX + output;
+
+			void insert( daw::string_view key, daw::string_view value ) {
+				if( key.size( ) > MAX_KEY_SIZE || value.size( ) > MAX_VALUE_SIZE ) {
+					return;
+				}
+				auto const h = hash( key );
+				auto & shard = shard_for( h );
+				std::lock_guard<std::mutex> lock( shard.mutex );
+				if( shard.entries.empty( ) ) {
+					return;
+				}
+				auto const first = (h % shard.bucket_count( )) * WAYS;
+				auto victim = first;
+				auto victim_frequency = SKETCH_MAX;
+				for( size_t n = first; n < first + WAYS; ++n ) {
+					auto const & entry = shard.entries[n];
+					if( entry.hash == 0 ) {
+						victim = n;
+						victim_frequency = 0;
+						break;
+					} else if( entry.matches( h, key ) ) {
+						return;
+					}
+					auto const f = shard.frequency( entry.hash );
+					if( f < victim_frequency ) {
+						victim = n;
+						victim_frequency = f;
+					}
+				}
+				if( victim_frequency != 0 && shard.frequency( h ) <= victim_frequency ) {
+					++shard.stats.rejected;
+					return;
+				}
+				auto & entry = shard.entries[victim];
+				entry.hash = h;
+				entry.key_size = static_cast<uint8_t>( key.size( ) );
+				entry.value_size = static_cast<uint8_t>( value.size( ) );
+				std::copy( key.begin( ), key.end( ), entry.key.begin( ) );
+				std::copy( value.begin( ), value.end( ), entry.value.begin( ) );
+				++shard.stats.admitted;
+			}
+		};
+
+		label_cache & encode_cache( ) {
+			static label_cache cache{ label_cache::DEFAULT_CAPACITY };
+			return cache;
 		}
 
-		template<typename Range>
-		constexpr bool begins_with_prefix( Range const & input ) noexcept {
-			return daw::parser::starts_with( input.begin( ), input.end( ), constants::PREFIX.begin( ), constants::PREFIX.end( ), []( auto c1, auto c2 ) {
-				return static_cast<uint32_t>(to_lower( c1 )) == static_cast<uint32_t>(to_lower( c2 ));
-			} );
+		label_cache & decode_cache( ) {
+			static label_cache cache{ label_cache::DEFAULT_CAPACITY };
+			return cache;
 		}
 
-		template<typename T>
-		constexpr size_t decode_to_value( T value ) {
-			if( daw::parser::in_range( value, 'a', 'z' ) ) {
-				return value - 'a';
-			} else if( daw::parser::in_range( value, 'A', 'Z' ) ) {
-				return value - 'A';
-			} else if( daw::parser::in_range( value, '0', '9' ) ) {
-				return (value - '0') + 26;
+		void encode_label( daw::string_view label, output_buffer & output ) {
+			// Basic labels are only lower cased, cheaper than a lookup
+			if( is_ascii( label.begin( ), label.end( ) ) ) {
+				encode_part( label, output );
+				return;
+			}
+			if( encode_cache( ).lookup( label, output ) ) {
+				return;
+			}
+			auto const start = output.size( );
+			encode_part( label, output );
+			if( output.fits( ) ) {
+				encode_cache( ).insert( label, output.written_since( start ) );
 			}
-			throw std::runtime_error( "Unexpected character provided" );
 		}
 
-		std::u32string decode_part( daw::range::CharRange u8input ) {
-			if( u8input.size( ) < 1 || u8input.size( ) > 63 ) {
-				throw std::runtime_error( "The size of the part must be between 1 and 63 inclusive" );
+		void decode_label( daw::string_view label, output_buffer & output ) {
+			if( !begins_with_prefix( label ) ) {
+				decode_part( label, output );
+				return;
 			}
-			if( !begins_with_prefix( u8input ) ) {
-				std::u32string result;
-				std::copy( u8input.begin( ), u8input.end( ), std::back_inserter( result ) );
-				return result;
-			} else {
-				u8input.advance( constants::PREFIX.size( ) );
+			if( decode_cache( ).lookup( label, output ) ) {
+				return;
+			}
+			auto const start = output.size( );
+			decode_part( label, output );
+			if( output.fits( ) ) {
+				decode_cache( ).insert( label, output.written_since( start ) );
+			}
+		}
+
+		// Converts each non-empty label of input.  Separators, including the UTS #46 full stops, are written as '.'
+		template<typename Convert>
+		size_t convert_labels( daw::string_view input, char * out, size_t capacity, Convert convert ) {
+			output_buffer output( out, capacity );
+			bool is_first = true;
+			for( auto const label : label_view( input ) ) {
+				if( !is_first ) {
+					output.push_back( '.' );
+				}
+				is_first = false;
+				if( !label.empty( ) ) {
+					convert( label, output );
+				}
 			}
-			auto input = u8input.to_u32string( );
+			return output.size( );
+		}
 
-			auto basic_rng = daw::parser::until_last_of( input.begin( ), input.end( ), U'-' );
+		// Hostnames are at most 253 bytes, so nearly every result fits here and the string is allocated once.  A larger
+		// one is converted again directly into a string of the size the first attempt reported
+		constexpr size_t const STACK_BUFFER_SIZE = 512;
 
-			std::u32string output;
-			if( basic_rng ) {
-				std::transform( basic_rng.begin( ), basic_rng.end( ), std::back_inserter( output ), []( auto c ) {
-					return static_cast<char32_t>( c );
-				} );
+		template<typename Convert>
+		std::string convert_to_string( daw::string_view input, Convert convert ) {
+			std::array<char, STACK_BUFFER_SIZE> buffer;
+			auto const size = convert_labels( input, buffer.data( ), buffer.size( ), convert );
+			if( size <= buffer.size( ) ) {
+				return std::string( buffer.data( ), size );
 			}
+			std::string result( size, '\0' );
+			convert_labels( input, &result[0], result.size( ), convert );
+			return result;
+		}
+	}    // namespace anonymous
 
-			auto n = constants::INITIAL_N;
-			auto bias = constants::INITIAL_BIAS;
+	void set_label_cache_capacity( size_t entries ) {
+		encode_cache( ).set_capacity( entries );
+		decode_cache( ).set_capacity( entries );
+	}
 
-			size_t b = basic_rng ? 1 + static_cast<size_t>(std::distance( basic_rng.begin( ), basic_rng.end( ) )) : 0;
+	void clear_label_cache( ) {
+		encode_cache( ).clear( );
+		decode_cache( ).clear( );
+	}
 
-			for( size_t i=0; b < input.size( ); ++i ) {
-				auto original_i = i;
-				size_t w = 1;
-				for( auto k = constants::BASE; ; k += constants::BASE ) {
-					auto d = decode_to_value( input[b++] );
+	label_cache_stats get_encode_label_cache_stats( ) {
+		return encode_cache( ).stats( );
+	}
 
-					i += d*w;
-					
-					auto t = calculate_threshold( k, bias );
-					if( d < t ) {
-						break;
-					}
-					w *= constants::BASE - t;
-				}
-				auto x = output.size( ) + 1;
-				bias = static_cast<uint32_t>(adapt( i - original_i, x, 0 == original_i ));
+	label_cache_stats get_decode_label_cache_stats( ) {
+		return decode_cache( ).stats( );
+	}
 
-				n += i/x;
+	std::string to_puny_code( daw::string_view input ) {
+		return convert_to_string( input, encode_label );
+	}
 
-				i %= x;
-				output.insert( i, 1, static_cast<char32_t>( n ) );
-			}
-			return output;
+	std::string from_puny_code( daw::string_view input ) {
+		return convert_to_string( input, decode_label );
+	}
+
+	size_t to_puny_code( daw::string_view input, char * out, size_t capacity ) {
+		return convert_labels( input, out, capacity, encode_label );
+	}
+
+	size_t from_puny_code( daw::string_view input, char * out, size_t capacity ) {
+		return convert_labels( input, out, capacity, decode_label );
+	}
+
+	char const * to_string( ace_error err ) noexcept {
+		switch( err ) {
+		case ace_error::none:
+			return "none";
+		case ace_error::invalid_length:
+			return "label must be between 5 and 63 characters inclusive";
+		case ace_error::missing_prefix:
+			return "label does not begin with xn--";
+		case ace_error::invalid_case:
+			return "label contains upper case characters";
+		case ace_error::invalid_character:
+			return "label contains a character that is not a letter, digit or hyphen";
+		case ace_error::misplaced_delimiter:
+			return "delimiter present without any basic code points";
+		case ace_error::no_encoded_code_points:
+			return "label does not encode any non-basic code points";
+		case ace_error::truncated_integer:
+			return "label ends in the middle of an encoded integer";
+		case ace_error::overflow:
+			return "encoded integer overflows";
+		case ace_error::encoded_basic_code_point:
+			return "label encodes a basic code point";
+		case ace_error::invalid_code_point:
+			return "label encodes a surrogate or a value past U+10FFFF";
+		case ace_error::encoded_label_separator:
+			return "label encodes a full stop that separates labels";
 		}
-	}    // namespace anonymous
+		return "unknown";
+	}
 
-	std::string to_puny_code( daw::string_view input ) {
-		std::stringstream ss;
-		auto parts = split( input, '.' );
-		bool is_first = true;
-		for( auto const & part : parts ) {
-			if( !is_first ) {
-				ss << '.';
-			} else {
-				is_first = false;
+	ace_error validate_ace( daw::string_view label ) noexcept {
+		// Canonical ACE labels have exactly one encoding, so decoding while checking each choice the encoder would have
+		// made is sufficient.  Only the length of the decoded output is needed, never its contents
+		if( label.size( ) <= constants::PREFIX.size( ) || label.size( ) > 63 ) {
+			return ace_error::invalid_length;
+		}
+		if( !begins_with_prefix( label ) ) {
+			return ace_error::missing_prefix;
+		}
+		if( !std::equal( constants::PREFIX.begin( ), constants::PREFIX.end( ), label.begin( ) ) ) {
+			return ace_error::invalid_case;
+		}
+		auto const first = label.begin( ) + constants::PREFIX.size( );
+		auto const last = label.end( );
+
+		// Everything before the last delimiter is basic, digits never contain one
+		auto digits = last;
+		while( digits != first && *(digits - 1) != constants::DELIMITER ) {
+			--digits;
+		}
+		if( digits == first + 1 ) {
+			return ace_error::misplaced_delimiter;
+		}
+		for( auto it = first; it + 1 < digits; ++it ) {
+			auto const c = *it;
+			if( daw::parser::in_range( c, 'A', 'Z' ) ) {
+				return ace_error::invalid_case;
 			}
-			if( !part.empty( ) ) {
-				ss << encode_part( daw::range::create_char_range( part.begin( ), part.end( ) ) );
+			if( !daw::parser::in_range( c, 'a', 'z' ) && !daw::parser::in_range( c, '0', '9' ) && c != constants::DELIMITER ) {
+				return ace_error::invalid_character;
 			}
 		}
-		return ss.str( );
-	}
+		if( digits == last ) {
+			return ace_error::no_encoded_code_points;
+		}
 
-	std::string from_puny_code( daw::string_view input ) {
-		auto parts = split( input, '.' );
-		bool is_first = true;
-		std::stringstream ss;
-		for( auto const & part: parts ) {
-			if( !is_first ) {
-				ss << '.';
-			} else {
-				is_first = false;
+		constexpr uint32_t const max_value = std::numeric_limits<uint32_t>::max( );
+		uint32_t output_size = digits == first ? 0 : static_cast<uint32_t>( digits - first - 1 );
+		uint32_t n = constants::INITIAL_N;
+		uint32_t bias = constants::INITIAL_BIAS;
+		uint32_t i = 0;
+		for( auto it = digits; it != last; ++i ) {
+			auto const original_i = i;
+			uint32_t w = 1;
+			for( auto k = constants::BASE;; k += constants::BASE ) {
+				if( it == last ) {
+					return ace_error::truncated_integer;
+				}
+				auto const c = *it++;
+				uint32_t d = 0;
+				if( daw::parser::in_range( c, 'a', 'z' ) ) {
+					d = static_cast<uint32_t>( c - 'a' );
+				} else if( daw::parser::in_range( c, '0', '9' ) ) {
+					d = static_cast<uint32_t>( c - '0' ) + 26;
+				} else if( daw::parser::in_range( c, 'A', 'Z' ) ) {
+					return ace_error::invalid_case;
+				} else {
+					return ace_error::invalid_character;
+				}
+				if( d > (max_value - i) / w ) {
+					return ace_error::overflow;
+				}
+				i += d * w;
+				auto const t = punycode::threshold( k, bias );
+				if( d < t ) {
+					break;
+				}
+				if( w > max_value / (constants::BASE - t) ) {
+					return ace_error::overflow;
+				}
+				w *= constants::BASE - t;
+			}
+			auto const x = output_size + 1;
+			bias = static_cast<uint32_t>( punycode::adapt( i - original_i, x, 0 == original_i ) );
+			if( i / x > max_value - n ) {
+				return ace_error::overflow;
+			}
+			n += i / x;
+			i %= x;
+			if( n < 0x80 ) {
+				return ace_error::encoded_basic_code_point;
+			}
+			if( n > 0x10FFFF || daw::parser::in_range( n, 0xD800u, 0xDFFFu ) ) {
+				return ace_error::invalid_code_point;
 			}
-			if( !part.empty( ) ) {
-				auto u32str = decode_part( daw::range::create_char_range( part.begin( ), part.end( ) ) );
-				ss << daw::from_u32string( u32str );
+			if( is_full_stop( n ) ) {
+				return ace_error::encoded_label_separator;
 			}
+			++output_size;
 		}
-		return ss.str( );
+		return ace_error::none;
 	}
 }    // namespace daw
 
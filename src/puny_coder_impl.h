@@ -0,0 +1,211 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+// Helpers shared by the Punycode engines in this library, the Bootstring arithmetic itself is daw::punycode.  Not
+// installed
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <daw/daw_parser_helper.h>
+#include <daw/daw_string_view.h>
+
+#include "puny_coder_bootstring.h"
+
+namespace daw {
+	namespace impl {
+		namespace constants {
+			constexpr uint32_t const BASE = punycode_parameters::BASE;
+			constexpr uint32_t const TMIN = punycode_parameters::TMIN;
+			constexpr uint32_t const TMAX = punycode_parameters::TMAX;
+			constexpr uint32_t const SKEW = punycode_parameters::SKEW;
+			constexpr uint32_t const DAMP = punycode_parameters::DAMP;
+			constexpr uint32_t const INITIAL_BIAS = punycode_parameters::INITIAL_BIAS;
+			constexpr uint32_t const INITIAL_N = punycode_parameters::INITIAL_N;
+			constexpr daw::string_view const PREFIX = "xn--";
+			constexpr auto const DELIMITER = punycode_parameters::DELIMITER;
+		}; // namespace costants
+
+		// The UTS #46 full stops, which to_puny_code treats as label separators like '.'
+		constexpr bool is_full_stop( uint32_t cp ) noexcept {
+			return cp == 0x3002 || cp == 0xFF0E || cp == 0xFF61;
+		}
+
+		template<typename CP>
+		constexpr auto to_lower( CP cp ) noexcept {
+			return cp | 32;
+		}
+
+		template<typename Range>
+		constexpr bool begins_with_prefix( Range const & input ) noexcept {
+			return daw::parser::starts_with( input.begin( ), input.end( ), constants::PREFIX.begin( ), constants::PREFIX.end( ), []( auto c1, auto c2 ) {
+				return static_cast<uint32_t>(to_lower( c1 )) == static_cast<uint32_t>(to_lower( c2 ));
+			} );
+		}
+
+		template<typename T>
+		constexpr size_t decode_to_value( T value ) {
+			auto const d = punycode_parameters::decode_digit( static_cast<uint32_t>( value ) );
+			if( d == constants::BASE ) {
+				throw std::runtime_error( "Unexpected character provided" );
+			}
+			return d;
+		}
+
+		// Strict UTF-8 decoding of one code point.  Returns false on malformed, overlong or surrogate sequences
+		inline bool decode_utf8( char const * & first, char const * last, uint32_t & cp ) noexcept {
+			auto const lead = static_cast<unsigned char>( *first );
+			size_t size = 0;
+			if( lead < 0x80 ) {
+				cp = lead;
+				++first;
+				return true;
+			} else if( lead >= 0xC2 && lead < 0xE0 ) {
+				size = 2;
+				cp = lead & 0x1Fu;
+			} else if( lead >= 0xE0 && lead < 0xF0 ) {
+				size = 3;
+				cp = lead & 0x0Fu;
+			} else if( lead >= 0xF0 && lead < 0xF5 ) {
+				size = 4;
+				cp = lead & 0x07u;
+			} else {
+				return false;
+			}
+			if( static_cast<size_t>( last - first ) < size ) {
+				return false;
+			}
+			for( size_t n = 1; n < size; ++n ) {
+				auto const c = static_cast<unsigned char>( first[n] );
+				if( ( c & 0xC0 ) != 0x80 ) {
+					return false;
+				}
+				cp = ( cp << 6 ) | ( c & 0x3Fu );
+			}
+			if( ( size == 3 && cp < 0x800 ) || ( size == 4 && ( cp < 0x10000 || cp > 0x10FFFF ) ) ||
+			    daw::parser::in_range( cp, 0xD800u, 0xDFFFu ) ) {
+				return false;
+			}
+			first += size;
+			return true;
+		}
+
+		template<typename Output>
+		void append_utf8( Output & out, uint32_t cp ) {
+			if( cp < 0x80 ) {
+				out.push_back( static_cast<char>( cp ) );
+			} else if( cp < 0x800 ) {
+				out.push_back( static_cast<char>( 0xC0 | ( cp >> 6 ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( cp & 0x3F ) ) );
+			} else if( cp < 0x10000 ) {
+				out.push_back( static_cast<char>( 0xE0 | ( cp >> 12 ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( cp & 0x3F ) ) );
+			} else {
+				out.push_back( static_cast<char>( 0xF0 | ( cp >> 18 ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+				out.push_back( static_cast<char>( 0x80 | ( cp & 0x3F ) ) );
+			}
+		}
+
+		// append_utf8 into a buffer with room for four bytes, returns one past the last byte written
+		inline char * write_utf8( char * out, uint32_t cp ) noexcept {
+			if( cp < 0x80 ) {
+				*out++ = static_cast<char>( cp );
+			} else if( cp < 0x800 ) {
+				*out++ = static_cast<char>( 0xC0 | ( cp >> 6 ) );
+				*out++ = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+			} else if( cp < 0x10000 ) {
+				*out++ = static_cast<char>( 0xE0 | ( cp >> 12 ) );
+				*out++ = static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+				*out++ = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+			} else {
+				*out++ = static_cast<char>( 0xF0 | ( cp >> 18 ) );
+				*out++ = static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+				*out++ = static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+				*out++ = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+			}
+			return out;
+		}
+
+#ifdef __AVX2__
+		// Truncating division of non-negative 32 bit values.  A double holds the quotient exactly enough that
+		// truncation gives the integer result
+		inline __m256i divide_lanes( __m256i a, __m256i b ) noexcept {
+			auto const lo = _mm256_div_pd( _mm256_cvtepi32_pd( _mm256_castsi256_si128( a ) ),
+			                               _mm256_cvtepi32_pd( _mm256_castsi256_si128( b ) ) );
+			auto const hi = _mm256_div_pd( _mm256_cvtepi32_pd( _mm256_extracti128_si256( a, 1 ) ),
+			                               _mm256_cvtepi32_pd( _mm256_extracti128_si256( b, 1 ) ) );
+			return _mm256_set_m128i( _mm256_cvttpd_epi32( hi ), _mm256_cvttpd_epi32( lo ) );
+		}
+
+		constexpr uint32_t ceil_log2( uint32_t value ) noexcept {
+			uint32_t result = 0;
+			while( ( uint64_t{ 1 } << result ) < value ) {
+				++result;
+			}
+			return result;
+		}
+
+		// Division of values below 2^31 by a constant, as a multiply and shift.  With P = 31 + ceil( log2( D ) ) the
+		// multiplier ceil( 2^P / D ) fits in 32 bits and is off by less than 1 / D, which does not change the floor
+		template<uint32_t D>
+		inline __m256i divide_lanes_by( __m256i a ) noexcept {
+			constexpr uint32_t const P = 31 + ceil_log2( D );
+			constexpr uint64_t const M = ( ( uint64_t{ 1 } << P ) + D - 1 ) / D;
+			auto const m = _mm256_set1_epi64x( static_cast<int64_t>( M ) );
+			auto const even = _mm256_srli_epi64( _mm256_mul_epu32( a, m ), P );
+			auto const odd = _mm256_srli_epi64( _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), m ), P );
+			return _mm256_or_si256( even, _mm256_slli_epi64( odd, 32 ) );
+		}
+
+		// punycode::adapt( ) for eight lanes at once.  Lanes outside mask get an unspecified bias, their n_points
+		// must still be non-zero.  Only the division by n_points needs doubles; the last one has operands below 2^14
+		// and a quotient of at most 36, which a float division gets exactly
+		inline __m256i adapt_lanes( __m256i delta, __m256i n_points, __m256i is_first, __m256i mask ) noexcept {
+			delta = _mm256_blendv_epi8( _mm256_srli_epi32( delta, 1 ), divide_lanes_by<constants::DAMP>( delta ), is_first );
+			delta = _mm256_add_epi32( delta, divide_lanes( delta, n_points ) );
+
+			auto const t = _mm256_set1_epi32( ( ( constants::BASE - constants::TMIN ) * constants::TMAX ) / 2 );
+			auto k = _mm256_setzero_si256( );
+			auto more = _mm256_and_si256( mask, _mm256_cmpgt_epi32( delta, t ) );
+			while( !_mm256_testz_si256( more, more ) ) {
+				delta = _mm256_blendv_epi8( delta, divide_lanes_by<constants::BASE - constants::TMIN>( delta ), more );
+				k = _mm256_add_epi32( k, _mm256_and_si256( more, _mm256_set1_epi32( constants::BASE ) ) );
+				more = _mm256_and_si256( mask, _mm256_cmpgt_epi32( delta, t ) );
+			}
+			auto const a = _mm256_mullo_epi32( _mm256_set1_epi32( constants::BASE - constants::TMIN + 1 ), delta );
+			auto const b = _mm256_add_epi32( delta, _mm256_set1_epi32( constants::SKEW ) );
+			return _mm256_add_epi32( k, _mm256_cvttps_epi32( _mm256_div_ps( _mm256_cvtepi32_ps( a ), _mm256_cvtepi32_ps( b ) ) ) );
+		}
+#endif
+	}    // namespace impl
+}    // namespace daw
@@ -0,0 +1,254 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <daw/daw_parser_helper.h>
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_impl.h"
+#include "puny_coder_rewrite.h"
+
+namespace daw {
+	namespace {
+		constexpr size_t const MAX_LABEL_SIZE = 63;
+
+		constexpr bool is_host_char( char c ) noexcept {
+			return daw::parser::in_range( c, 'a', 'z' ) || daw::parser::in_range( c, 'A', 'Z' ) ||
+			       daw::parser::in_range( c, '0', '9' ) || c == '-' || c == '.';
+		}
+
+		constexpr bool is_edge_char( char c ) noexcept {
+			return c == '.' || c == '-';
+		}
+
+		struct code_point_range {
+			uint32_t first;
+			uint32_t last;
+		};
+
+		// Non-ASCII code points that end a hostname: the C1 controls and the punctuation (P*) and separators (Z*) of
+		// the scripts found in running text, plus the zero width space and byte order mark.  The UTS #46 full stops
+		// U+3002, U+FF0E and U+FF61 are left out as they separate labels.  Sorted
+		constexpr code_point_range const NON_HOST_CODE_POINTS[] = {
+		  { 0x0080, 0x00A1 }, { 0x00A7, 0x00A7 }, { 0x00AB, 0x00AB }, { 0x00B6, 0x00B7 }, { 0x00BB, 0x00BB },
+		  { 0x00BF, 0x00BF }, { 0x037E, 0x037E }, { 0x0387, 0x0387 }, { 0x055A, 0x055F }, { 0x0589, 0x058A },
+		  { 0x05BE, 0x05BE }, { 0x05C0, 0x05C0 }, { 0x05C3, 0x05C3 }, { 0x05C6, 0x05C6 }, { 0x05F3, 0x05F4 },
+		  { 0x0609, 0x060A }, { 0x060C, 0x060D }, { 0x061B, 0x061B }, { 0x061D, 0x061F }, { 0x066A, 0x066D },
+		  { 0x06D4, 0x06D4 }, { 0x0964, 0x0965 }, { 0x0970, 0x0970 }, { 0x0E4F, 0x0E4F }, { 0x0E5A, 0x0E5B },
+		  { 0x1680, 0x1680 }, { 0x2000, 0x200B }, { 0x2010, 0x2029 }, { 0x202F, 0x2043 }, { 0x2045, 0x2051 },
+		  { 0x2053, 0x205F }, { 0x207D, 0x207E }, { 0x208D, 0x208E }, { 0x2308, 0x230B }, { 0x2329, 0x232A },
+		  { 0x2768, 0x2775 }, { 0x27C5, 0x27C6 }, { 0x27E6, 0x27EF }, { 0x2983, 0x2998 }, { 0x29D8, 0x29DB },
+		  { 0x29FC, 0x29FD }, { 0x2E00, 0x2E4F }, { 0x3000, 0x3001 }, { 0x3003, 0x3003 }, { 0x3008, 0x3011 },
+		  { 0x3014, 0x301F }, { 0x3030, 0x3030 }, { 0x303D, 0x303D }, { 0x30A0, 0x30A0 }, { 0x30FB, 0x30FB },
+		  { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE52 }, { 0xFE54, 0xFE61 }, { 0xFE63, 0xFE63 }, { 0xFE68, 0xFE68 },
+		  { 0xFE6A, 0xFE6B }, { 0xFEFF, 0xFEFF }, { 0xFF01, 0xFF03 }, { 0xFF05, 0xFF0A }, { 0xFF0C, 0xFF0D },
+		  { 0xFF0F, 0xFF0F }, { 0xFF1A, 0xFF1B }, { 0xFF1F, 0xFF20 }, { 0xFF3B, 0xFF3D }, { 0xFF3F, 0xFF3F },
+		  { 0xFF5B, 0xFF5B }, { 0xFF5D, 0xFF5D }, { 0xFF5F, 0xFF60 }, { 0xFF62, 0xFF65 } };
+
+		bool is_host_code_point( uint32_t cp ) noexcept {
+			if( cp < 0x80 ) {
+				return is_host_char( static_cast<char>( cp ) );
+			}
+			auto const range = std::upper_bound( std::begin( NON_HOST_CODE_POINTS ), std::end( NON_HOST_CODE_POINTS ), cp,
+			                                     []( uint32_t value, code_point_range const & r ) { return value < r.first; } );
+			return range == std::begin( NON_HOST_CODE_POINTS ) || cp > range[-1].last;
+		}
+
+		// The size of the hostname character at position, 0 if there is none.  Malformed UTF-8 ends a hostname
+		size_t host_char_size( char const * position, char const * last ) noexcept {
+			if( static_cast<unsigned char>( *position ) < 0x80 ) {
+				return is_host_char( *position ) ? 1 : 0;
+			}
+			auto next = position;
+			uint32_t cp = 0;
+			if( !impl::decode_utf8( next, last, cp ) || !is_host_code_point( cp ) ) {
+				return 0;
+			}
+			return static_cast<size_t>( next - position );
+		}
+
+		// The size of the hostname character ending at position, not reaching before first, 0 if there is none
+		size_t host_char_size_before( char const * first, char const * position ) noexcept {
+			if( position == first ) {
+				return 0;
+			}
+			auto start = position - 1;
+			while( start != first && position - start < 4 && ( static_cast<unsigned char>( *start ) & 0xC0u ) == 0x80u ) {
+				--start;
+			}
+			auto const size = host_char_size( start, position );
+			return start + size == position ? size : 0;
+		}
+
+		// True at an xn-- prefix: position is the first of the two hyphens and the xn starts a label
+		bool is_ace_prefix( char const * first, char const * position ) noexcept {
+			if( position - first < 2 || impl::to_lower( position[-2] ) != 'x' || impl::to_lower( position[-1] ) != 'n' ) {
+				return false;
+			}
+			return host_char_size_before( first, position - 2 ) == 0 || position[-3] == '.';
+		}
+
+		// The next position that could be inside a hostname to convert: the hyphens of xn-- or a non-ASCII byte
+		char const * find_candidate( char const * first, char const * position, char const * last, rewrite_direction direction ) noexcept {
+#ifdef __SSE2__
+			auto const dash = _mm_set1_epi8( '-' );
+			// 17 bytes are read for the hyphen pair test
+			for( ; last - position > 16; position += 16 ) {
+				auto const block = _mm_loadu_si128( reinterpret_cast<__m128i const *>( position ) );
+				uint32_t mask = 0;
+				if( direction == rewrite_direction::to_ace ) {
+					mask = static_cast<uint32_t>( _mm_movemask_epi8( block ) );
+				} else {
+					auto const next = _mm_loadu_si128( reinterpret_cast<__m128i const *>( position + 1 ) );
+					mask = static_cast<uint32_t>( _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( block, dash ), _mm_cmpeq_epi8( next, dash ) ) ) );
+				}
+				for( ; mask != 0; mask &= mask - 1 ) {
+					size_t offset = 0;
+					while( ( mask & ( 1u << offset ) ) == 0 ) {
+						++offset;
+					}
+					if( direction == rewrite_direction::to_ace || is_ace_prefix( first, position + offset ) ) {
+						return position + offset;
+					}
+				}
+			}
+#endif
+			for( ; position != last; ++position ) {
+				if( direction == rewrite_direction::to_ace ) {
+					if( static_cast<unsigned char>( *position ) >= 0x80 ) {
+						return position;
+					}
+				} else if( *position == '-' && position + 1 != last && position[1] == '-' && is_ace_prefix( first, position ) ) {
+					return position;
+				}
+			}
+			return last;
+		}
+
+		// Labels of 1 to 63 bytes, and the requirements of the direction
+		bool should_convert( daw::string_view host, rewrite_direction direction ) noexcept {
+			size_t label_count = 0;
+			bool has_ace = false;
+			while( !host.empty( ) ) {
+				auto const dot = std::find( host.begin( ), host.end( ), '.' );
+				auto const label = host.substr( 0, static_cast<size_t>( dot - host.begin( ) ) );
+				if( label.empty( ) || label.size( ) > MAX_LABEL_SIZE ) {
+					return false;
+				}
+				++label_count;
+				if( direction == rewrite_direction::to_unicode && impl::begins_with_prefix( label ) ) {
+					// Upper case ACE labels are still decoded
+					auto const error = validate_ace( label );
+					if( error != ace_error::none && error != ace_error::invalid_case ) {
+						return false;
+					}
+					has_ace = true;
+				}
+				host.remove_prefix( std::min( host.size( ), label.size( ) + 1 ) );
+			}
+			return direction == rewrite_direction::to_unicode ? has_ace : label_count > 1;
+		}
+
+		bool is_ascii_or_utf8( daw::string_view host, rewrite_direction direction ) noexcept {
+			auto first = host.begin( );
+			bool non_ascii = false;
+			while( first != host.end( ) ) {
+				uint32_t cp = 0;
+				if( !impl::decode_utf8( first, host.end( ), cp ) ) {
+					return false;
+				}
+				non_ascii = non_ascii || cp >= 0x80;
+			}
+			// Decoding copies the bytes of non-ACE labels as code points, which is only correct for ASCII
+			return direction == rewrite_direction::to_ace || !non_ascii;
+		}
+	}    // namespace anonymous
+
+	rewrite_stats rewrite_hostnames( daw::string_view text, rewrite_direction direction, std::string & output ) {
+		rewrite_stats stats;
+		auto const first = text.data( );
+		auto const last = first + text.size( );
+		// Everything before copied has been written to output, nothing before position is a candidate
+		auto copied = first;
+		auto position = first;
+		output.reserve( output.size( ) + text.size( ) );
+		while( ( position = find_candidate( first, position, last, direction ) ) != last ) {
+			// The hostname is the run of hostname characters around the candidate, decoded as UTF-8 so that quotes,
+			// spaces and other punctuation next to it are not taken in
+			auto host_last = position;
+			while( host_last != last ) {
+				auto const size = host_char_size( host_last, last );
+				if( size == 0 ) {
+					break;
+				}
+				host_last += size;
+			}
+			if( host_last == position ) {
+				// Not itself part of a hostname, such as a quote
+				++position;
+				continue;
+			}
+			auto host_first = position;
+			while( auto const size = host_char_size_before( copied, host_first ) ) {
+				host_first -= size;
+			}
+			position = host_last;
+			while( host_first != host_last && is_edge_char( *host_first ) ) {
+				++host_first;
+			}
+			while( host_last != host_first && is_edge_char( host_last[-1] ) ) {
+				--host_last;
+			}
+			daw::string_view const host{ host_first, static_cast<size_t>( host_last - host_first ) };
+			if( host.empty( ) ) {
+				continue;
+			}
+			++stats.found;
+			if( !is_ascii_or_utf8( host, direction ) || !should_convert( host, direction ) ) {
+				continue;
+			}
+			std::string converted;
+			try {
+				converted = direction == rewrite_direction::to_ace ? to_puny_code( host ) : from_puny_code( host );
+			} catch( std::exception const & ) {
+				continue;
+			}
+			output.append( copied, host_first );
+			output += converted;
+			copied = host_last;
+			++stats.rewritten;
+		}
+		output.append( copied, last );
+		return stats;
+	}
+}    // namespace daw
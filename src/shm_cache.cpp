@@ -0,0 +1,378 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+#include "puny_coder_shm_cache.h"
+
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2, "The shared cache requires lock-free 64bit atomics" );
+
+namespace daw {
+	namespace {
+		constexpr uint64_t const MAGIC = 0x7075'6e79'6361'6368ULL; // punycach
+		constexpr uint32_t const VERSION = 2;
+		constexpr size_t const ENTRY_SIZE = 512;
+		constexpr size_t const PROBE_LIMIT = 8;
+		// A live writer holds an entry for microseconds.  After STALE_WRITE_MS an entry is reclaimed if its writer's
+		// process is gone, after ABANDONED_WRITE_MS whatever became of the writer
+		constexpr uint32_t const STALE_WRITE_MS = 100;
+		constexpr uint32_t const ABANDONED_WRITE_MS = 10'000;
+		constexpr uint64_t const READY = 1;
+
+		struct segment_header {
+			uint64_t magic;
+			uint32_t version;
+			uint32_t entry_size;
+			uint64_t entry_count;
+			std::atomic<uint64_t> state;
+			char padding[ENTRY_SIZE - 32];
+		};
+		static_assert( sizeof( segment_header ) == ENTRY_SIZE, "Header must occupy one entry" );
+
+		struct entry_t {
+			// Even when stable, twice the generation of the last write.  Odd while a writer owns the entry, when it is
+			// that writer's lock word
+			std::atomic<uint64_t> sequence;
+			// Counts the writes, so every write publishes a sequence no reader has seen before
+			std::atomic<uint64_t> generation;
+			uint64_t tag;
+			uint32_t checksum;
+			uint16_t key_size;
+			uint16_t value_size;
+			char data[ENTRY_SIZE - 32];
+		};
+		static_assert( sizeof( entry_t ) == ENTRY_SIZE, "Entries must be fixed size" );
+
+		constexpr size_t const MAX_DATA_SIZE = sizeof( entry_t::data );
+
+		uint32_t now_ms( ) noexcept {
+			return static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::milliseconds>(
+			                                std::chrono::steady_clock::now( ).time_since_epoch( ) )
+			                                .count( ) );
+		}
+
+		// The owner's pid and the time it took the entry in one odd value.  Ownership is taken by swapping the whole
+		// word, so a writer reclaiming an entry replaces exactly the lock it judged stale and the old owner can no
+		// longer publish
+		uint64_t lock_word( uint32_t now ) noexcept {
+			return ( static_cast<uint64_t>( now ) << 32u ) | ( ( static_cast<uint64_t>( getpid( ) ) & 0x7FFF'FFFFu ) << 1u ) | 1u;
+		}
+
+		bool is_abandoned( uint64_t lock, uint32_t now ) noexcept {
+			// Unsigned, so the millisecond clock may wrap
+			auto const held = now - static_cast<uint32_t>( lock >> 32u );
+			if( held < STALE_WRITE_MS ) {
+				return false;
+			} else if( held >= ABANDONED_WRITE_MS ) {
+				return true;
+			}
+			auto const owner = static_cast<pid_t>( ( lock >> 1u ) & 0x7FFF'FFFFu );
+			return kill( owner, 0 ) < 0 && errno == ESRCH;
+		}
+
+		uint64_t hash_key( conversion_direction direction, daw::string_view key ) noexcept {
+			uint64_t result = 14695981039346656037ULL ^ static_cast<uint64_t>( direction );
+			for( auto c : key ) {
+				result ^= static_cast<unsigned char>( c );
+				result *= 1099511628211ULL;
+			}
+			return result == 0 ? 1 : result;
+		}
+
+		uint32_t checksum( uint64_t tag, char const * data, size_t key_size, size_t value_size ) noexcept {
+			uint32_t result = 2166136261u ^ static_cast<uint32_t>( tag ) ^ static_cast<uint32_t>( key_size << 16 | value_size );
+			for( size_t n = 0; n < key_size + value_size; ++n ) {
+				result ^= static_cast<unsigned char>( data[n] );
+				result *= 16777619u;
+			}
+			return result;
+		}
+
+		segment_header * header_of( void * base ) noexcept {
+			return static_cast<segment_header *>( base );
+		}
+
+		entry_t * entries_of( void * base ) noexcept {
+			return reinterpret_cast<entry_t *>( static_cast<char *>( base ) + sizeof( segment_header ) );
+		}
+
+		std::runtime_error system_error( char const * what ) {
+			return std::runtime_error( std::string( what ) + ": " + std::strerror( errno ) );
+		}
+
+		size_t segment_size( size_t entry_count ) noexcept {
+			return sizeof( segment_header ) + entry_count * sizeof( entry_t );
+		}
+
+		void * map_segment( int fd, size_t size ) {
+			auto const base = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+			if( base == MAP_FAILED ) {
+				throw system_error( "mmap" );
+			}
+			return base;
+		}
+
+		void initialize( void * base, size_t entry_count ) noexcept {
+			// The entries are zero filled by ftruncate, which is an empty and stable state
+			auto header = header_of( base );
+			header->magic = MAGIC;
+			header->version = VERSION;
+			header->entry_size = static_cast<uint32_t>( ENTRY_SIZE );
+			header->entry_count = entry_count;
+			header->state.store( READY, std::memory_order_release );
+		}
+	}    // namespace anonymous
+
+	shared_conversion_cache::shared_conversion_cache( void * base, size_t size, int fd ) noexcept
+	  : m_base( base ), m_size( size ), m_fd( fd ) {}
+
+	void shared_conversion_cache::release( ) noexcept {
+		if( m_base != nullptr ) {
+			munmap( m_base, m_size );
+			m_base = nullptr;
+		}
+		if( m_fd >= 0 ) {
+			close( m_fd );
+			m_fd = -1;
+		}
+	}
+
+	shared_conversion_cache shared_conversion_cache::open( std::string const & name, size_t entry_count ) {
+		if( entry_count == 0 ) {
+			throw std::invalid_argument( "entry_count must be greater than 0" );
+		}
+		auto const size = segment_size( entry_count );
+		auto fd = shm_open( name.c_str( ), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600 );
+		if( fd >= 0 ) {
+			if( ftruncate( fd, static_cast<off_t>( size ) ) < 0 ) {
+				auto const ex = system_error( "ftruncate" );
+				close( fd );
+				shm_unlink( name.c_str( ) );
+				throw ex;
+			}
+			shared_conversion_cache result( map_segment( fd, size ), size, fd );
+			initialize( result.m_base, entry_count );
+			return result;
+		}
+		if( errno != EEXIST ) {
+			throw system_error( "shm_open" );
+		}
+		fd = shm_open( name.c_str( ), O_RDWR | O_CLOEXEC, 0600 );
+		if( fd < 0 ) {
+			throw system_error( "shm_open" );
+		}
+		// Wait for the creating process to size and initialize the segment
+		auto const deadline = std::chrono::steady_clock::now( ) + std::chrono::seconds( 5 );
+		while( true ) {
+			struct stat st;
+			if( fstat( fd, &st ) == 0 && static_cast<size_t>( st.st_size ) == size ) {
+				shared_conversion_cache result( map_segment( fd, size ), size, fd );
+				auto header = header_of( result.m_base );
+				while( header->state.load( std::memory_order_acquire ) != READY ) {
+					if( std::chrono::steady_clock::now( ) > deadline ) {
+						throw std::runtime_error( "Shared cache " + name + " was never initialized" );
+					}
+					std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+				}
+				if( header->magic != MAGIC || header->version != VERSION || header->entry_size != ENTRY_SIZE ||
+				    header->entry_count != entry_count ) {
+					throw std::runtime_error( "Shared cache " + name + " has an incompatible layout" );
+				}
+				return result;
+			}
+			if( std::chrono::steady_clock::now( ) > deadline ) {
+				close( fd );
+				throw std::runtime_error( "Shared cache " + name + " has an unexpected size" );
+			}
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		}
+	}
+
+	shared_conversion_cache shared_conversion_cache::create_anonymous( size_t entry_count ) {
+		if( entry_count == 0 ) {
+			throw std::invalid_argument( "entry_count must be greater than 0" );
+		}
+		auto const size = segment_size( entry_count );
+		auto const fd = memfd_create( "puny_coder_cache", MFD_CLOEXEC );
+		if( fd < 0 ) {
+			throw system_error( "memfd_create" );
+		}
+		if( ftruncate( fd, static_cast<off_t>( size ) ) < 0 ) {
+			auto const ex = system_error( "ftruncate" );
+			close( fd );
+			throw ex;
+		}
+		shared_conversion_cache result( map_segment( fd, size ), size, fd );
+		initialize( result.m_base, entry_count );
+		return result;
+	}
+
+	void shared_conversion_cache::remove( std::string const & name ) {
+		if( shm_unlink( name.c_str( ) ) < 0 && errno != ENOENT ) {
+			throw system_error( "shm_unlink" );
+		}
+	}
+
+	shared_conversion_cache::shared_conversion_cache( shared_conversion_cache && other ) noexcept
+	  : m_base( other.m_base ), m_size( other.m_size ), m_fd( other.m_fd ) {
+		other.m_base = nullptr;
+		other.m_fd = -1;
+	}
+
+	shared_conversion_cache & shared_conversion_cache::operator=( shared_conversion_cache && other ) noexcept {
+		if( this != &other ) {
+			release( );
+			m_base = other.m_base;
+			m_size = other.m_size;
+			m_fd = other.m_fd;
+			other.m_base = nullptr;
+			other.m_fd = -1;
+		}
+		return *this;
+	}
+
+	shared_conversion_cache::~shared_conversion_cache( ) {
+		release( );
+	}
+
+	size_t shared_conversion_cache::entry_count( ) const noexcept {
+		return static_cast<size_t>( header_of( m_base )->entry_count );
+	}
+
+	bool shared_conversion_cache::find( conversion_direction direction, daw::string_view key, std::string & value ) const {
+		if( key.size( ) >= MAX_DATA_SIZE ) {
+			return false;
+		}
+		auto const tag = hash_key( direction, key );
+		auto const count = entry_count( );
+		auto const entries = entries_of( m_base );
+		char buffer[MAX_DATA_SIZE];
+		for( size_t probe = 0; probe < PROBE_LIMIT; ++probe ) {
+			auto & entry = entries[( tag + probe ) % count];
+			auto const seq = entry.sequence.load( std::memory_order_acquire );
+			if( seq & 1 ) {
+				continue;
+			}
+			auto const entry_tag = entry.tag;
+			auto const key_size = entry.key_size;
+			auto const value_size = entry.value_size;
+			auto const sum = entry.checksum;
+			if( entry_tag == tag && key_size == key.size( ) && key_size + value_size <= MAX_DATA_SIZE ) {
+				std::memcpy( buffer, entry.data, key_size + value_size );
+			}
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if( entry.sequence.load( std::memory_order_relaxed ) != seq ) {
+				// Changed under us, treat as a miss for this slot
+				continue;
+			}
+			if( entry_tag == 0 ) {
+				return false;
+			}
+			if( entry_tag != tag || key_size != key.size( ) || key_size + value_size > MAX_DATA_SIZE ) {
+				continue;
+			}
+			if( checksum( entry_tag, buffer, key_size, value_size ) != sum ||
+			    !std::equal( key.begin( ), key.end( ), buffer ) ) {
+				continue;
+			}
+			value.assign( buffer + key_size, value_size );
+			return true;
+		}
+		return false;
+	}
+
+	void shared_conversion_cache::insert( conversion_direction direction, daw::string_view key, daw::string_view value ) {
+		if( key.size( ) + value.size( ) > MAX_DATA_SIZE ) {
+			return;
+		}
+		auto const tag = hash_key( direction, key );
+		auto const count = entry_count( );
+		auto const entries = entries_of( m_base );
+
+		// Prefer an empty slot in the probe window, otherwise evict one chosen by the hash
+		auto target = &entries[( tag + ( ( tag >> 32 ) % PROBE_LIMIT ) ) % count];
+		for( size_t probe = 0; probe < PROBE_LIMIT; ++probe ) {
+			auto & entry = entries[( tag + probe ) % count];
+			auto const seq = entry.sequence.load( std::memory_order_acquire );
+			if( ( seq & 1 ) == 0 && entry.tag == 0 ) {
+				target = &entry;
+				break;
+			}
+		}
+
+		auto seq = target->sequence.load( std::memory_order_acquire );
+		auto const now = now_ms( );
+		// Another writer owns it.  Only take over if that writer is gone or has held it far too long
+		if( ( seq & 1 ) != 0 && !is_abandoned( seq, now ) ) {
+			return;
+		}
+		auto lock = lock_word( now );
+		if( !target->sequence.compare_exchange_strong( seq, lock, std::memory_order_acquire ) ) {
+			return;
+		}
+		auto const published = ( target->generation.fetch_add( 1, std::memory_order_relaxed ) + 1 ) << 1u;
+		std::atomic_thread_fence( std::memory_order_release );
+
+		target->tag = tag;
+		target->key_size = static_cast<uint16_t>( key.size( ) );
+		target->value_size = static_cast<uint16_t>( value.size( ) );
+		std::memcpy( target->data, key.data( ), key.size( ) );
+		std::memcpy( target->data + key.size( ), value.data( ), value.size( ) );
+		target->checksum = checksum( tag, target->data, key.size( ), value.size( ) );
+
+		// A writer that stalled long enough to be taken over must not publish over the new owner
+		target->sequence.compare_exchange_strong( lock, published, std::memory_order_release, std::memory_order_relaxed );
+	}
+
+	std::string shared_conversion_cache::to_puny_code( daw::string_view input ) {
+		std::string result;
+		if( !find( conversion_direction::encode, input, result ) ) {
+			result = daw::to_puny_code( input );
+			insert( conversion_direction::encode, input, result );
+		}
+		return result;
+	}
+
+	std::string shared_conversion_cache::from_puny_code( daw::string_view input ) {
+		std::string result;
+		if( !find( conversion_direction::decode, input, result ) ) {
+			result = daw::from_puny_code( input );
+			insert( conversion_direction::decode, input, result );
+		}
+		return result;
+	}
+}    // namespace daw
@@ -0,0 +1,138 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define BOOST_TEST_MODULE allocation_test
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <daw/boost_test.h>
+#include <daw/daw_string_view.h>
+
+#include "counting_allocator.h"
+#include "puny_coder.h"
+#include "puny_coder_hostname.h"
+
+namespace {
+	// Unicode and ACE forms of the same names, plus plain ASCII ones that only need lower casing
+	std::vector<std::string> const unicode_hosts = { "bücher.ch", "пример.испытание", "www.例え.テスト", "😀.example.com",
+	                                                 "Ünïcödé.de", "WWW.Example.COM", "mail.xn--bcher-kva.ch", "a.b.c.d.e.f" };
+
+	std::vector<std::string> const ace_hosts = { "xn--bcher-kva.ch", "xn--e1afmkfd.xn--80akhbyknj4f", "www.xn--r8jz45g.xn--zckzah",
+	                                             "xn--e28h.example.com", "xn--ncd-0ma6a3ab.de", "www.example.com", "a.b.c.d.e.f" };
+
+	template<typename Function>
+	size_t count_allocations( Function f ) {
+		daw::testing::allocation_scope scope;
+		f( );
+		return scope.allocations( );
+	}
+
+	// Runs every conversion once so that function local statics such as the label caches exist
+	void warm_up( ) {
+		for( auto const & host : unicode_hosts ) {
+			daw::to_puny_code( host );
+		}
+		for( auto const & host : ace_hosts ) {
+			daw::from_puny_code( host );
+		}
+	}
+
+	void check_budgets( ) {
+		std::array<char, 256> buffer;
+		for( auto const & host : unicode_hosts ) {
+			auto const buffer_allocations = count_allocations( [&]( ) {
+				BOOST_REQUIRE( daw::to_puny_code( host, buffer.data( ), buffer.size( ) ) <= buffer.size( ) );
+			} );
+			BOOST_REQUIRE_MESSAGE( buffer_allocations == 0, "to_puny_code buffer " << host << ": " << buffer_allocations );
+			BOOST_REQUIRE( count_allocations( [&]( ) { daw::to_puny_code_hostname( host ); } ) == 0 );
+			auto const string_allocations = count_allocations( [&]( ) { daw::to_puny_code( host ); } );
+			BOOST_REQUIRE_MESSAGE( string_allocations <= 1, "to_puny_code " << host << ": " << string_allocations );
+		}
+		for( auto const & host : ace_hosts ) {
+			auto const buffer_allocations = count_allocations( [&]( ) {
+				BOOST_REQUIRE( daw::from_puny_code( host, buffer.data( ), buffer.size( ) ) <= buffer.size( ) );
+			} );
+			BOOST_REQUIRE_MESSAGE( buffer_allocations == 0, "from_puny_code buffer " << host << ": " << buffer_allocations );
+			BOOST_REQUIRE( count_allocations( [&]( ) { daw::from_puny_code_hostname( host ); } ) == 0 );
+			auto const string_allocations = count_allocations( [&]( ) { daw::from_puny_code( host ); } );
+			BOOST_REQUIRE_MESSAGE( string_allocations <= 1, "from_puny_code " << host << ": " << string_allocations );
+		}
+	}
+}    // namespace anonymous
+
+BOOST_AUTO_TEST_CASE( allocation_test_counter ) {
+	auto const allocations = count_allocations( []( ) {
+		std::vector<int> v( 100 );
+		BOOST_REQUIRE( v.size( ) == 100 );
+	} );
+	BOOST_REQUIRE( allocations == 1 );
+}
+
+BOOST_AUTO_TEST_CASE( allocation_test_cached ) {
+	daw::set_label_cache_capacity( 4096 );
+	warm_up( );
+	check_budgets( );
+}
+
+BOOST_AUTO_TEST_CASE( allocation_test_uncached ) {
+	daw::set_label_cache_capacity( 0 );
+	warm_up( );
+	check_budgets( );
+	daw::set_label_cache_capacity( 4096 );
+}
+
+BOOST_AUTO_TEST_CASE( allocation_test_queries ) {
+	warm_up( );
+	for( auto const & host : ace_hosts ) {
+		BOOST_REQUIRE( count_allocations( [&]( ) { daw::classify_hostname( host ); } ) == 0 );
+		for( auto const & label : daw::split( host, '.' ) ) {
+			BOOST_REQUIRE( count_allocations( [&]( ) { daw::validate_ace( label ); } ) == 0 );
+		}
+	}
+}
+
+// Heap in use at the peak of each batch, the buffer API should leave it flat however many names are converted
+BOOST_AUTO_TEST_CASE( allocation_test_high_water ) {
+	warm_up( );
+	std::array<char, 256> buffer;
+	for( size_t batch_size : { 10, 1000, 100000 } ) {
+		daw::testing::allocation_scope buffer_scope;
+		for( size_t n = 0; n < batch_size; ++n ) {
+			daw::to_puny_code( unicode_hosts[n % unicode_hosts.size( )], buffer.data( ), buffer.size( ) );
+		}
+		BOOST_REQUIRE( buffer_scope.high_water( ) == 0 );
+
+		daw::testing::allocation_scope string_scope;
+		std::vector<std::string> results;
+		results.reserve( batch_size );
+		for( size_t n = 0; n < batch_size; ++n ) {
+			results.push_back( daw::to_puny_code( unicode_hosts[n % unicode_hosts.size( )] ) );
+		}
+		std::cout << "batch of " << batch_size << ": buffer API high water 0 bytes, string API "
+		          << string_scope.allocations( ) << " allocations, high water " << string_scope.high_water( )
+		          << " bytes\n";
+	}
+}
@@ -0,0 +1,358 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define BOOST_TEST_MODULE conformance_test
+
+// Runs every conversion engine in the library over the RFC 3492 section 7.1 samples and the error free cases of the
+// Unicode IdnaTestV2 data, with the label caches on and off.  This library only does the Punycode step of IDNA, so
+// from IdnaTestV2 it takes the toUnicode/toAsciiN pairs, which are the mapped name and its ACE form
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <daw/boost_test.h>
+#include <daw/daw_parser_helper.h>
+#include <daw/daw_string_view.h>
+#include <daw/json/daw_json_link.h>
+#include <daw/json/daw_json_link_file.h>
+
+#include "puny_coder.h"
+#include "puny_coder_bootstring.h"
+#include "puny_coder_hostname.h"
+#include "puny_coder_incremental.h"
+#include "puny_coder_labels.h"
+
+struct puny_tests_t : public daw::json::daw_json_link<puny_tests_t> {
+	struct puny_test_t : public daw::json::daw_json_link<puny_test_t> {
+		std::string in;
+		std::string out;
+
+		static void json_link_map( ) {
+			link_json_string( "in", in );
+			link_json_string( "out", out );
+		}
+	}; // puny_test_t
+
+	std::vector<puny_test_t> tests;
+
+	static void json_link_map( ) {
+		link_json_object_array( "tests", tests );
+	}
+}; // puny_tests_t
+
+namespace {
+	struct conformance_case {
+		std::string unicode;
+		std::string ace;
+	};
+
+	std::string trim( std::string const & value ) {
+		auto const first = value.find_first_not_of( " \t" );
+		if( first == std::string::npos ) {
+			return std::string( );
+		}
+		return value.substr( first, value.find_last_not_of( " \t" ) - first + 1 );
+	}
+
+	void append_utf8( std::string & out, uint32_t cp ) {
+		if( cp < 0x80 ) {
+			out += static_cast<char>( cp );
+		} else if( cp < 0x800 ) {
+			out += static_cast<char>( 0xC0 | ( cp >> 6 ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		} else if( cp < 0x10000 ) {
+			out += static_cast<char>( 0xE0 | ( cp >> 12 ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		} else {
+			out += static_cast<char>( 0xF0 | ( cp >> 18 ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+		}
+	}
+
+	template<typename CodePoints>
+	std::string to_utf8( CodePoints const & code_points ) {
+		std::string result;
+		for( auto cp : code_points ) {
+			append_utf8( result, static_cast<uint32_t>( cp ) );
+		}
+		return result;
+	}
+
+	// The byte length of each UTF-8 sequence in value, which is valid UTF-8
+	std::vector<size_t> code_point_sizes( daw::string_view value ) {
+		std::vector<size_t> result;
+		for( size_t pos = 0; pos < value.size( ); ) {
+			auto const lead = static_cast<unsigned char>( value[pos] );
+			size_t const size = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+			result.push_back( size );
+			pos += size;
+		}
+		return result;
+	}
+
+	std::u32string to_code_points( daw::string_view value ) {
+		std::u32string result;
+		size_t pos = 0;
+		for( auto size : code_point_sizes( value ) ) {
+			auto cp = static_cast<uint32_t>( static_cast<unsigned char>( value[pos] ) ) & ( size == 1 ? 0x7Fu : 0xFFu >> ( size + 1 ) );
+			for( size_t n = 1; n < size; ++n ) {
+				cp = ( cp << 6 ) | ( static_cast<unsigned char>( value[pos + n] ) & 0x3Fu );
+			}
+			result.push_back( static_cast<char32_t>( cp ) );
+			pos += size;
+		}
+		return result;
+	}
+
+	// Undoes the \uXXXX and \x{XXXX} escapes and the "" used for empty values
+	std::string unescape( std::string const & value ) {
+		if( value == "\"\"" ) {
+			return std::string( );
+		}
+		std::string result;
+		for( size_t pos = 0; pos < value.size( ); ) {
+			if( value[pos] == '\\' && pos + 1 < value.size( ) && ( value[pos + 1] == 'u' || value[pos + 1] == 'x' ) ) {
+				size_t first = pos + 2;
+				size_t last = first + 4;
+				if( value[pos + 1] == 'x' ) {
+					first = pos + 3;
+					last = value.find( '}', first );
+				}
+				append_utf8( result, static_cast<uint32_t>( std::stoul( value.substr( first, last - first ), nullptr, 16 ) ) );
+				pos = value[pos + 1] == 'x' ? last + 1 : last;
+			} else {
+				result += value[pos++];
+			}
+		}
+		return result;
+	}
+
+	std::vector<conformance_case> load_idna_tests( std::string const & path ) {
+		std::ifstream in( path );
+		BOOST_REQUIRE_MESSAGE( in, "Could not open " + path );
+		std::vector<conformance_case> result;
+		std::string line;
+		while( std::getline( in, line ) ) {
+			line = line.substr( 0, line.find( '#' ) );
+			std::vector<std::string> columns;
+			for( size_t first = 0; first <= line.size( ); ) {
+				auto const last = std::min( line.find( ';', first ), line.size( ) );
+				columns.push_back( trim( line.substr( first, last - first ) ) );
+				first = last + 1;
+			}
+			if( columns.size( ) < 5 ) {
+				continue;
+			}
+			// Blank means no errors for toUnicode and the same as toUnicode's status for toAsciiN
+			auto const & to_unicode_status = columns[2];
+			auto const & to_ascii_status = columns[4];
+			if( !to_unicode_status.empty( ) || !( to_ascii_status.empty( ) || to_ascii_status == "[]" ) ) {
+				continue;
+			}
+			auto const source = unescape( columns[0] );
+			auto unicode = columns[1].empty( ) ? source : unescape( columns[1] );
+			auto ace = columns[3].empty( ) ? unicode : unescape( columns[3] );
+			result.push_back( { std::move( unicode ), std::move( ace ) } );
+		}
+		return result;
+	}
+
+	std::vector<conformance_case> load_rfc3492_samples( std::string const & path ) {
+		auto const samples = daw::json::from_file<puny_tests_t>( path );
+		std::vector<conformance_case> result;
+		for( auto const & sample : samples.tests ) {
+			result.push_back( { sample.in, sample.out } );
+		}
+		return result;
+	}
+
+	// Decoding cannot restore the case of ASCII letters
+	bool equal_nc( daw::string_view lhs, daw::string_view rhs ) {
+		return std::equal( lhs.begin( ), lhs.end( ), rhs.begin( ), rhs.end( ), []( char l, char r ) {
+			return ( daw::parser::in_range( l, 'A', 'Z' ) ? l | 0x20 : l ) == ( daw::parser::in_range( r, 'A', 'Z' ) ? r | 0x20 : r );
+		} );
+	}
+
+	std::vector<daw::string_view> split_labels( daw::string_view host ) {
+		std::vector<daw::string_view> result;
+		for( auto const label : daw::label_view( host ) ) {
+			result.push_back( label );
+		}
+		return result;
+	}
+
+	std::string join_labels( std::vector<std::string> const & labels ) {
+		std::string result;
+		for( auto const & label : labels ) {
+			if( &label != &labels.front( ) ) {
+				result += '.';
+			}
+			result += label;
+		}
+		return result;
+	}
+
+	template<typename Function>
+	std::string guarded( Function f ) {
+		try {
+			return f( );
+		} catch( std::exception const & ex ) {
+			return std::string( "exception: " ) + ex.what( );
+		}
+	}
+
+	void check_case( conformance_case const & test_case ) {
+		auto const & unicode = test_case.unicode;
+		auto const & ace = test_case.ace;
+		auto const report = [&]( char const * engine, bool encode, std::string const & result ) {
+			auto const ok = encode ? result == ace : equal_nc( result, unicode );
+			BOOST_CHECK_MESSAGE( ok, engine << ( encode ? " encoding '" : " decoding '" ) << ( encode ? unicode : ace )
+			                                << "' expected '" << ( encode ? ace : unicode ) << "' got '" << result << "'" );
+		};
+
+		// The encoders are Bootstring and accept any length, the decoders also enforce the 63 byte DNS label limit,
+		// which RFC 3492 sample (I) exceeds
+		auto const labels = split_labels( ace );
+		auto const decodable = std::all_of( labels.begin( ), labels.end( ), []( auto label ) { return label.size( ) <= 63; } );
+
+		report( "string", true, guarded( [&]( ) { return daw::to_puny_code( unicode ); } ) );
+
+		// As if typed a code point at a time, each prefix encoded as to_puny_code would
+		report( "incremental", true, guarded( [&]( ) {
+			daw::incremental_encoder encoder;
+			size_t typed = 0;
+			for( auto size : code_point_sizes( unicode ) ) {
+				encoder.append( daw::string_view{ unicode.data( ) + typed, size } );
+				typed += size;
+				auto const prefix = daw::string_view{ unicode.data( ), typed };
+				BOOST_CHECK_MESSAGE( guarded( [&]( ) { return encoder.ace( ).to_string( ); } ) ==
+				                       guarded( [&]( ) { return daw::to_puny_code( prefix ); } ),
+				                     "incremental encoding '" << prefix << "' differs from to_puny_code" );
+			}
+			return encoder.ace( ).to_string( );
+		} ) );
+
+		// daw::punycode and punycode_decoder on the Bootstring payload of each ACE label.  They neither lower case nor
+		// check label lengths
+		auto const unicode_labels = split_labels( unicode );
+		BOOST_REQUIRE( unicode_labels.size( ) == labels.size( ) );
+		for( size_t n = 0; n < labels.size( ); ++n ) {
+			auto const label = labels[n];
+			if( label.size( ) < 4 || !equal_nc( daw::string_view{ label.data( ), 4 }, "xn--" ) ) {
+				continue;
+			}
+			auto const payload = label.substr( 4 );
+			auto const encoded = guarded( [&]( ) { return daw::punycode::encode( to_code_points( unicode_labels[n] ) ); } );
+			BOOST_CHECK_MESSAGE( equal_nc( encoded, payload ),
+			                     "punycode encoding '" << unicode_labels[n] << "' expected '" << payload << "' got '" << encoded << "'" );
+			auto const decoded = guarded( [&]( ) { return to_utf8( daw::punycode::decode( payload ) ); } );
+			BOOST_CHECK_MESSAGE( equal_nc( decoded, unicode_labels[n] ),
+			                     "punycode decoding '" << payload << "' expected '" << unicode_labels[n] << "' got '" << decoded << "'" );
+
+			// punycode_decoder, pushed the payload in chunks of 1 to 4 characters
+			for( size_t chunk = 1; chunk <= 4; ++chunk ) {
+				auto const streamed = guarded( [&]( ) {
+					daw::punycode_decoder decoder;
+					for( size_t pos = 0; pos < payload.size( ); pos += chunk ) {
+						decoder.push( payload.substr( pos, chunk ) );
+					}
+					std::vector<uint32_t> code_points;
+					decoder.finish( code_points );
+					return to_utf8( code_points );
+				} );
+				BOOST_CHECK_MESSAGE( equal_nc( streamed, unicode_labels[n] ), "punycode_decoder with " << chunk << " character chunks decoding '"
+				                                                               << payload << "' expected '" << unicode_labels[n]
+				                                                               << "' got '" << streamed << "'" );
+			}
+		}
+
+		if( !decodable ) {
+			BOOST_CHECK_THROW( daw::from_puny_code( ace ), std::runtime_error );
+			BOOST_CHECK_THROW( daw::decode_labels( labels ), std::runtime_error );
+			return;
+		}
+		report( "string", false, guarded( [&]( ) { return daw::from_puny_code( ace ); } ) );
+
+		std::array<char, 1024> buffer;
+		report( "buffer", true, guarded( [&]( ) {
+			return std::string( buffer.data( ), daw::to_puny_code( unicode, buffer.data( ), buffer.size( ) ) );
+		} ) );
+		report( "buffer", false, guarded( [&]( ) {
+			return std::string( buffer.data( ), daw::from_puny_code( ace, buffer.data( ), buffer.size( ) ) );
+		} ) );
+
+		report( "batch", true, guarded( [&]( ) { return join_labels( daw::encode_labels( split_labels( unicode ) ) ); } ) );
+		report( "batch", false, guarded( [&]( ) { return join_labels( daw::decode_labels( labels ) ); } ) );
+
+		// hostname only holds results of up to 255 bytes
+		if( ace.size( ) <= daw::hostname::MAX_SIZE ) {
+			report( "hostname", true, guarded( [&]( ) { return daw::to_puny_code_hostname( unicode ).to_string( ); } ) );
+			report( "shared_hostname", true, guarded( [&]( ) { return daw::shared_hostname( unicode ).ace( ).to_string( ); } ) );
+			report( "shared_hostname", false, guarded( [&]( ) { return daw::shared_hostname( ace ).unicode( ).to_string( ); } ) );
+		}
+		if( unicode.size( ) <= daw::hostname::MAX_SIZE ) {
+			report( "hostname", false, guarded( [&]( ) { return daw::from_puny_code_hostname( ace ).to_string( ); } ) );
+		}
+
+		for( auto const label : labels ) {
+			if( label.size( ) >= 4 && equal_nc( daw::string_view{ label.data( ), 4 }, "xn--" ) ) {
+				auto const err = daw::validate_ace( label );
+				BOOST_CHECK_MESSAGE( err == daw::ace_error::none, "validate_ace rejected '" << label << "': " << daw::to_string( err ) );
+			}
+		}
+	}
+
+	void check_all( std::vector<conformance_case> const & cases ) {
+		for( size_t capacity : { 4096, 0 } ) {
+			daw::set_label_cache_capacity( capacity );
+			// Twice so that the second pass is answered by the caches when they are on
+			for( size_t pass = 0; pass < 2; ++pass ) {
+				for( auto const & test_case : cases ) {
+					check_case( test_case );
+				}
+			}
+		}
+		daw::set_label_cache_capacity( 4096 );
+	}
+}    // namespace anonymous
+
+BOOST_AUTO_TEST_CASE( conformance_test_rfc3492_samples ) {
+	auto const cases = load_rfc3492_samples( "../rfc3492_samples.json" );
+	BOOST_REQUIRE( cases.size( ) == 18 );
+	check_all( cases );
+}
+
+BOOST_AUTO_TEST_CASE( conformance_test_idna_test_v2 ) {
+	auto const cases = load_idna_tests( "../IdnaTestV2.txt" );
+	std::cout << "IdnaTestV2: " << cases.size( ) << " error free cases\n";
+	BOOST_REQUIRE( !cases.empty( ) );
+	check_all( cases );
+}
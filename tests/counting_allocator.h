@@ -0,0 +1,152 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+// Replaces the global operator new and delete with versions that count calls and track live heap bytes.  The
+// replacements are definitions, so include this in exactly one translation unit of a program
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace daw {
+	namespace testing {
+		struct allocation_counters {
+			std::atomic<size_t> allocations;
+			std::atomic<size_t> allocated_bytes;
+			std::atomic<size_t> live_bytes;
+			std::atomic<size_t> high_water;
+		};
+
+		// Constant initialized, so it is usable from the first allocation of the program
+		allocation_counters g_allocation_counters{ { 0 }, { 0 }, { 0 }, { 0 } };
+
+		// Counts what happens between construction and the calls to the accessors.  The high water mark is the
+		// largest amount of heap in use above what was live at construction
+		class allocation_scope {
+			size_t m_allocations;
+			size_t m_bytes;
+			size_t m_live;
+
+		public:
+			allocation_scope( ) noexcept
+			  : m_allocations( g_allocation_counters.allocations.load( ) )
+			  , m_bytes( g_allocation_counters.allocated_bytes.load( ) )
+			  , m_live( g_allocation_counters.live_bytes.load( ) ) {
+				g_allocation_counters.high_water.store( m_live );
+			}
+
+			size_t allocations( ) const noexcept {
+				return g_allocation_counters.allocations.load( ) - m_allocations;
+			}
+
+			size_t bytes( ) const noexcept {
+				return g_allocation_counters.allocated_bytes.load( ) - m_bytes;
+			}
+
+			size_t high_water( ) const noexcept {
+				auto const peak = g_allocation_counters.high_water.load( );
+				return peak > m_live ? peak - m_live : 0;
+			}
+		};
+
+		namespace impl {
+			// The size is kept in front of each block so delete can account for it
+			constexpr size_t const HEADER_SIZE = alignof( std::max_align_t ) > sizeof( size_t ) ? alignof( std::max_align_t ) : sizeof( size_t );
+
+			inline void * counted_allocate( size_t size ) noexcept {
+				auto const block = static_cast<char *>( std::malloc( size + HEADER_SIZE ) );
+				if( !block ) {
+					return nullptr;
+				}
+				*reinterpret_cast<size_t *>( block ) = size;
+				auto & counters = g_allocation_counters;
+				counters.allocations.fetch_add( 1 );
+				counters.allocated_bytes.fetch_add( size );
+				auto const live = counters.live_bytes.fetch_add( size ) + size;
+				auto peak = counters.high_water.load( );
+				while( live > peak && !counters.high_water.compare_exchange_weak( peak, live ) ) { }
+				return block + HEADER_SIZE;
+			}
+
+			inline void counted_free( void * ptr ) noexcept {
+				if( !ptr ) {
+					return;
+				}
+				auto const block = static_cast<char *>( ptr ) - HEADER_SIZE;
+				g_allocation_counters.live_bytes.fetch_sub( *reinterpret_cast<size_t *>( block ) );
+				std::free( block );
+			}
+
+			inline void * counted_new( size_t size ) {
+				auto const result = counted_allocate( size == 0 ? 1 : size );
+				if( !result ) {
+					throw std::bad_alloc( );
+				}
+				return result;
+			}
+		}    // namespace impl
+	}    // namespace testing
+}    // namespace daw
+
+void * operator new( size_t size ) {
+	return daw::testing::impl::counted_new( size );
+}
+
+void * operator new[]( size_t size ) {
+	return daw::testing::impl::counted_new( size );
+}
+
+void * operator new( size_t size, std::nothrow_t const & ) noexcept {
+	return daw::testing::impl::counted_allocate( size == 0 ? 1 : size );
+}
+
+void * operator new[]( size_t size, std::nothrow_t const & ) noexcept {
+	return daw::testing::impl::counted_allocate( size == 0 ? 1 : size );
+}
+
+void operator delete( void * ptr ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
+
+void operator delete[]( void * ptr ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
+
+void operator delete( void * ptr, size_t ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
+
+void operator delete[]( void * ptr, size_t ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
+
+void operator delete( void * ptr, std::nothrow_t const & ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
+
+void operator delete[]( void * ptr, std::nothrow_t const & ) noexcept {
+	daw::testing::impl::counted_free( ptr );
+}
@@ -22,7 +22,16 @@
 
 #define BOOST_TEST_MODULE puny_coder_test 
 
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
 
 #include <daw/boost_test.h>
 #include <daw/char_range/daw_char_range.h>
@@ -32,6 +41,23 @@
 #include <daw/json/daw_json_link_file.h>
 
 #include "puny_coder.h"
+#include "puny_coder_bootstring.h"
+#include "puny_coder_dictionary.h"
+#include "puny_coder_filter.h"
+#include "puny_coder_incremental.h"
+#include "puny_coder_packed.h"
+#include "puny_coder_hostname.h"
+#include "puny_coder_rewrite.h"
+#include "puny_coder_index.h"
+#include "puny_coder_labels.h"
+
+#if defined( __linux__ )
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "puny_coder_shm_cache.h"
+#endif
 
 struct puny_tests_t : public daw::json::daw_json_link<puny_tests_t> {
 	struct puny_test_t : public daw::json::daw_json_link<puny_test_t> {
@@ -96,3 +122,722 @@ BOOST_AUTO_TEST_CASE( punycode_test_decode ) {
 	std::cout << std::endl;
 }
 
+BOOST_AUTO_TEST_CASE( punycode_test_label_cache ) {
+	daw::clear_label_cache( );
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	for( size_t n = 0; n < 3; ++n ) {
+		for( auto const & puny : config_data.tests ) {
+			BOOST_REQUIRE( daw::to_puny_code( puny.in ) == puny.out );
+			BOOST_REQUIRE( equal_nc( to_u32string( daw::from_puny_code( puny.out ) ), to_u32string( puny.in ) ) );
+		}
+	}
+	auto const enc_stats = daw::get_encode_label_cache_stats( );
+	auto const dec_stats = daw::get_decode_label_cache_stats( );
+	BOOST_REQUIRE( enc_stats.hits > 0 );
+	BOOST_REQUIRE( dec_stats.hits > 0 );
+
+	daw::set_label_cache_capacity( 0 );
+	BOOST_REQUIRE( daw::to_puny_code( "Bücher.ch" ) == "xn--bcher-kva.ch" );
+	BOOST_REQUIRE( daw::get_encode_label_cache_stats( ).capacity == 0 );
+	daw::set_label_cache_capacity( 4096 );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_validate_ace ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	for( auto const & puny : config_data.tests ) {
+		for( auto const & part : split( daw::string_view{ puny.out }, '.' ) ) {
+			if( part.size( ) > 4 && part[0] == 'x' ) {
+				BOOST_REQUIRE( daw::validate_ace( part ) == daw::ace_error::none );
+			}
+		}
+	}
+	BOOST_REQUIRE( daw::validate_ace( "xn--" ) == daw::ace_error::invalid_length );
+	BOOST_REQUIRE( daw::validate_ace( "bcher-kva" ) == daw::ace_error::missing_prefix );
+	BOOST_REQUIRE( daw::validate_ace( "XN--bcher-kva" ) == daw::ace_error::invalid_case );
+	BOOST_REQUIRE( daw::validate_ace( "xn--Bcher-kva" ) == daw::ace_error::invalid_case );
+	BOOST_REQUIRE( daw::validate_ace( "xn--bcher-KVA" ) == daw::ace_error::invalid_case );
+	BOOST_REQUIRE( daw::validate_ace( "xn--b_cher-kva" ) == daw::ace_error::invalid_character );
+	BOOST_REQUIRE( daw::validate_ace( "xn---3s9h" ) == daw::ace_error::misplaced_delimiter );
+	BOOST_REQUIRE( daw::validate_ace( "xn--bcher-" ) == daw::ace_error::no_encoded_code_points );
+	BOOST_REQUIRE( daw::validate_ace( "xn--bcher-kv" ) == daw::ace_error::truncated_integer );
+	BOOST_REQUIRE( daw::validate_ace( "xn--99999999999" ) == daw::ace_error::overflow );
+	BOOST_REQUIRE( daw::validate_ace( "xn--99999a" ) == daw::ace_error::invalid_code_point );
+	// Decodes to "com。", which to_puny_code would split into two labels
+	BOOST_REQUIRE( daw::validate_ace( "xn--com-bz3b" ) == daw::ace_error::encoded_label_separator );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_classify_hostname ) {
+	using daw::hostname_class;
+	auto const type_of = []( daw::string_view host ) {
+		return daw::classify_hostname( host ).type;
+	};
+	BOOST_REQUIRE( type_of( "www.example.com" ) == hostname_class::ascii_ldh );
+	BOOST_REQUIRE( type_of( "www.example.com." ) == hostname_class::ascii_ldh );
+	BOOST_REQUIRE( type_of( "xn--bcher-kva.ch" ) == hostname_class::contains_ace );
+	BOOST_REQUIRE( type_of( "XN--BCHER-KVA.ch" ) == hostname_class::contains_ace );
+	BOOST_REQUIRE( type_of( "www.ハンドボールサムズ.com" ) == hostname_class::contains_non_ascii );
+	BOOST_REQUIRE( type_of( "192.168.0.1" ) == hostname_class::ipv4_literal );
+	BOOST_REQUIRE( type_of( "::1" ) == hostname_class::ipv6_literal );
+	BOOST_REQUIRE( type_of( "[2001:db8::ff00:42:8329]" ) == hostname_class::ipv6_literal );
+	BOOST_REQUIRE( type_of( "::ffff:192.0.2.128" ) == hostname_class::ipv6_literal );
+	BOOST_REQUIRE( type_of( "" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "a..b" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "-a.com" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "a_b.com" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "256.1.1.1" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "example.123" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( "1:2:3:4:5:6:7:8:9" ) == hostname_class::invalid );
+	BOOST_REQUIRE( type_of( std::string( 64, 'a' ) + ".com" ) == hostname_class::invalid );
+
+	daw::string_view const host = "a.bb.this-is-a-longer-label.xn--fiqs8s";
+	auto const info = daw::classify_hostname( host );
+	BOOST_REQUIRE( info.label_count == 4 );
+	BOOST_REQUIRE( info.label( host, 0 ) == "a" );
+	BOOST_REQUIRE( info.label( host, 2 ) == "this-is-a-longer-label" );
+	BOOST_REQUIRE( info.label( host, 3 ) == "xn--fiqs8s" );
+}
+
+#if defined( __linux__ )
+BOOST_AUTO_TEST_CASE( punycode_test_shared_cache ) {
+	auto cache = daw::shared_conversion_cache::create_anonymous( 1024 );
+	std::string value;
+	BOOST_REQUIRE( !cache.find( daw::conversion_direction::encode, "Bücher.ch", value ) );
+
+	// Populate from a child process, the parent should see its entries
+	auto const pid = fork( );
+	BOOST_REQUIRE( pid >= 0 );
+	if( pid == 0 ) {
+		cache.to_puny_code( "Bücher.ch" );
+		cache.from_puny_code( "xn--fjqz24b.xn--fiqs8s" );
+		_exit( 0 );
+	}
+	int status = 0;
+	waitpid( pid, &status, 0 );
+	BOOST_REQUIRE( cache.find( daw::conversion_direction::encode, "Bücher.ch", value ) );
+	BOOST_REQUIRE( value == "xn--bcher-kva.ch" );
+	BOOST_REQUIRE( cache.find( daw::conversion_direction::decode, "xn--fjqz24b.xn--fiqs8s", value ) );
+	BOOST_REQUIRE( value == "快乐.中国" );
+	BOOST_REQUIRE( !cache.find( daw::conversion_direction::decode, "Bücher.ch", value ) );
+	BOOST_REQUIRE( cache.to_puny_code( "快乐.中国" ) == "xn--fjqz24b.xn--fiqs8s" );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_shared_cache_stress ) {
+	// Few entries and long values, so processes keep writing over each other and are often killed mid-write
+	auto cache = daw::shared_conversion_cache::create_anonymous( 16 );
+	size_t const key_count = 64;
+	auto const key_of = []( size_t n ) { return "stress-" + std::to_string( n ) + ".example"; };
+	auto const value_of = []( size_t n ) {
+		return std::string( 400, static_cast<char>( 'a' + n % 26 ) ) + std::to_string( n );
+	};
+	auto const hammer = [&]( unsigned seed, size_t iterations ) {
+		std::mt19937 rng( seed );
+		std::string value;
+		for( size_t i = 0; i < iterations; ++i ) {
+			auto const n = rng( ) % key_count;
+			auto const key = key_of( n );
+			if( cache.find( daw::conversion_direction::decode, key, value ) && value != value_of( n ) ) {
+				return false;
+			}
+			cache.insert( daw::conversion_direction::decode, key, value_of( n ) );
+		}
+		return true;
+	};
+
+	std::vector<pid_t> workers;
+	for( unsigned n = 0; n < 4; ++n ) {
+		auto const pid = fork( );
+		BOOST_REQUIRE( pid >= 0 );
+		if( pid == 0 ) {
+			_exit( hammer( n, 200'000 ) ? 0 : 1 );
+		}
+		workers.push_back( pid );
+	}
+	// Writers that die holding an entry
+	for( unsigned n = 0; n < 20; ++n ) {
+		auto const pid = fork( );
+		BOOST_REQUIRE( pid >= 0 );
+		if( pid == 0 ) {
+			hammer( 100 + n, std::numeric_limits<size_t>::max( ) );
+			_exit( 0 );
+		}
+		std::this_thread::sleep_for( std::chrono::microseconds( 500 + 100 * n ) );
+		kill( pid, SIGKILL );
+		waitpid( pid, nullptr, 0 );
+	}
+	for( auto pid : workers ) {
+		int status = 0;
+		waitpid( pid, &status, 0 );
+		BOOST_REQUIRE( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+	}
+	BOOST_REQUIRE( hammer( 1000, 10'000 ) );
+
+	// Once stale, entries left busy by the killed writers are reclaimed
+	std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+	std::string value;
+	for( size_t n = 0; n < key_count; ++n ) {
+		cache.insert( daw::conversion_direction::decode, key_of( n ), value_of( n ) );
+		BOOST_REQUIRE( cache.find( daw::conversion_direction::decode, key_of( n ), value ) );
+		BOOST_REQUIRE( value == value_of( n ) );
+	}
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( punycode_test_conversion_index ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	std::vector<std::string> hostnames;
+	for( auto const & puny : config_data.tests ) {
+		hostnames.push_back( puny.in );
+	}
+	daw::write_conversion_index( hostnames, "puny_coder_test.idx" );
+	auto const index = daw::conversion_index::open( "puny_coder_test.idx" );
+	BOOST_REQUIRE( index.verify( ) );
+	for( auto const & puny : config_data.tests ) {
+		daw::string_view result;
+		if( puny.in == puny.out ) {
+			BOOST_REQUIRE( !index.find_ace( puny.in, result ) );
+			continue;
+		}
+		BOOST_REQUIRE( index.find_ace( puny.in, result ) );
+		BOOST_REQUIRE( result == puny.out );
+		BOOST_REQUIRE( index.find_unicode( puny.out, result ) );
+		BOOST_REQUIRE( equal_nc( to_u32string( result ), to_u32string( puny.in ) ) );
+	}
+	BOOST_REQUIRE( index.to_puny_code( "bücher.de" ) == "xn--bcher-kva.de" );
+
+	// Slots pointing past the strings are misses rather than reads outside the mapping.  The slots start after the 80
+	// byte header, 32 bytes each with the value offset at byte 16
+	std::string bytes;
+	{
+		std::ifstream in( "puny_coder_test.idx", std::ios::binary );
+		bytes.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>( ) );
+	}
+	uint64_t bucket_count = 0;
+	std::memcpy( &bucket_count, bytes.data( ) + 24, sizeof( bucket_count ) );
+	uint64_t const bad_offset = 1ULL << 62;
+	for( uint64_t slot = 0; slot < 2 * bucket_count; ++slot ) {
+		std::memcpy( &bytes[80 + slot * 32 + 16], &bad_offset, sizeof( bad_offset ) );
+	}
+	auto const write_bytes = [&bytes]( ) {
+		std::ofstream out( "puny_coder_test_corrupt.idx", std::ios::binary | std::ios::trunc );
+		out.write( bytes.data( ), static_cast<std::streamsize>( bytes.size( ) ) );
+	};
+	write_bytes( );
+	{
+		auto const corrupt = daw::conversion_index::open( "puny_coder_test_corrupt.idx" );
+		BOOST_REQUIRE( !corrupt.verify( ) );
+		daw::string_view result;
+		BOOST_REQUIRE( !corrupt.find_ace( "bücher.de", result ) );
+		BOOST_REQUIRE( !corrupt.find_unicode( "xn--bcher-kva.de", result ) );
+		BOOST_REQUIRE( corrupt.to_puny_code( "bücher.de" ) == "xn--bcher-kva.de" );
+	}
+	// A bucket count larger than the file
+	uint64_t const huge_count = 1ULL << 60;
+	std::memcpy( &bytes[24], &huge_count, sizeof( huge_count ) );
+	write_bytes( );
+	BOOST_REQUIRE_THROW( daw::conversion_index::open( "puny_coder_test_corrupt.idx" ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_idn_filter ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	std::vector<std::string> hostnames;
+	for( size_t n = 0; n < config_data.tests.size( ); ++n ) {
+		// Mix both input forms
+		hostnames.push_back( n % 2 == 0 ? config_data.tests[n].in : config_data.tests[n].out );
+	}
+	for( size_t n = 0; n < 1000; ++n ) {
+		hostnames.push_back( "host" + std::to_string( n ) + ".xn--fiqs8s" );
+	}
+	daw::idn_filter::build( hostnames ).save( "puny_coder_test.xor" );
+	auto const filter = daw::idn_filter::open( "puny_coder_test.xor" );
+	BOOST_REQUIRE( filter.size( ) == hostnames.size( ) );
+	for( auto const & puny : config_data.tests ) {
+		BOOST_REQUIRE( filter.may_contain_ace( puny.out ) );
+		BOOST_REQUIRE( filter.may_contain( puny.in ) );
+	}
+	BOOST_REQUIRE( filter.may_contain_ace( "XN--BCHER-KVA.CH" ) );
+	size_t false_positives = 0;
+	for( size_t n = 0; n < 10000; ++n ) {
+		false_positives += filter.may_contain_ace( "other" + std::to_string( n ) + ".example" ) ? 1 : 0;
+	}
+	BOOST_REQUIRE( false_positives < 100 );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_concurrent ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	daw::clear_label_cache( );
+	std::vector<std::thread> threads;
+	std::vector<size_t> failures( 8, 0 );
+	for( size_t t = 0; t < failures.size( ); ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			for( size_t n = 0; n < 2000; ++n ) {
+				auto const & puny = config_data.tests[( n + t ) % config_data.tests.size( )];
+				failures[t] += daw::to_puny_code( puny.in ) != puny.out ? 1 : 0;
+				failures[t] += !equal_nc( to_u32string( daw::from_puny_code( puny.out ) ), to_u32string( puny.in ) ) ? 1 : 0;
+			}
+		} );
+	}
+	for( auto & th : threads ) {
+		th.join( );
+	}
+	for( auto f : failures ) {
+		BOOST_REQUIRE( f == 0 );
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( punycode_test_encode_labels ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	std::vector<std::string> storage;
+	for( auto const & puny : config_data.tests ) {
+		for( auto const & label : daw::split( puny.in, '.' ) ) {
+			storage.push_back( label.to_string( ) );
+		}
+	}
+	// Uneven lane lengths, repeated code points and labels longer than a lane holds
+	storage.push_back( "ÄäÄäÄäÄä" );
+	storage.push_back( "a-ü-b-ü-c" );
+	storage.push_back( "ü" );
+	storage.push_back( "😀🎉日本語" );
+	storage.push_back( "MiXeD-ascii" );
+	storage.push_back( std::string( 70, 'x' ) + "é" );
+	storage.push_back( "" );
+	// Full stops, which to_puny_code treats as separators
+	storage.push_back( "a。b" );
+	storage.push_back( "ü．x｡y" );
+	storage.push_back( "ü.x" );
+	storage.push_back( "a.ü.b" );
+	std::vector<daw::string_view> labels;
+	for( auto const & label : storage ) {
+		labels.emplace_back( label );
+	}
+	auto const results = daw::encode_labels( labels );
+	BOOST_REQUIRE( results.size( ) == labels.size( ) );
+	for( size_t n = 0; n < labels.size( ); ++n ) {
+		BOOST_REQUIRE_MESSAGE( results[n] == daw::to_puny_code( labels[n] ), storage[n] );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_decode_labels ) {
+	auto config_data = daw::json::from_file<puny_tests_t>( "../puny_coder_tests.json" );
+	std::vector<std::string> storage;
+	for( auto const & puny : config_data.tests ) {
+		for( auto const & label : daw::split( puny.out, '.' ) ) {
+			storage.push_back( label.to_string( ) );
+		}
+	}
+	// Upper case digits, a basic part only, a truncated integer and an overflowing one
+	storage.push_back( "XN--BCHER-KVA" );
+	storage.push_back( "xn--abc-" );
+	storage.push_back( "xn--abc-9" );
+	storage.push_back( "xn--99999a" );
+	storage.push_back( "www" );
+	std::vector<daw::string_view> labels;
+	for( auto const & label : storage ) {
+		labels.emplace_back( label );
+	}
+	auto const guarded = []( auto f ) -> std::string {
+		try {
+			return f( );
+		} catch( std::exception const & ) {
+			return "error";
+		}
+	};
+	std::vector<daw::string_view> valid;
+	for( auto const & label : labels ) {
+		auto const expected = guarded( [&]( ) { return daw::from_puny_code( label ); } );
+		BOOST_REQUIRE_MESSAGE( expected == guarded( [&]( ) { return daw::decode_labels( { label } ).front( ); } ), label.to_string( ) );
+		if( expected != "error" ) {
+			valid.push_back( label );
+		}
+	}
+	auto const results = daw::decode_labels( valid );
+	for( size_t n = 0; n < valid.size( ); ++n ) {
+		BOOST_REQUIRE_MESSAGE( results[n] == daw::from_puny_code( valid[n] ), valid[n].to_string( ) );
+	}
+	// Past U+10FFFF
+	BOOST_REQUIRE_THROW( daw::from_puny_code( "xn--99999a" ), std::runtime_error );
+	BOOST_REQUIRE_THROW( daw::decode_labels( { "xn--99999a" } ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_label_shapes ) {
+	daw::set_label_cache_capacity( 0 );
+	// One non-basic code point, repeated, an emoji, one script block and a mix that needs the general engine
+	BOOST_REQUIRE( daw::to_puny_code( "bücher" ) == "xn--bcher-kva" );
+	BOOST_REQUIRE( daw::to_puny_code( "büchüer" ) == "xn--bcher-kvac" );
+	BOOST_REQUIRE( daw::to_puny_code( "😀" ) == "xn--e28h" );
+	BOOST_REQUIRE( daw::to_puny_code( "пример" ) == "xn--e1afmkfd" );
+	BOOST_REQUIRE( daw::to_puny_code( "ĀāĂ" ) == "xn--xdacd" );
+	BOOST_REQUIRE( daw::to_puny_code( "a-ü-b-ü" ) == "xn--a--b--lvad" );
+	BOOST_REQUIRE( daw::to_puny_code( "ü😀" ) == "xn--tda4367w" );
+	daw::set_label_cache_capacity( 4096 );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_rewrite_hostnames ) {
+	std::string out;
+	auto stats = daw::rewrite_hostnames( "GET http://xn--bcher-kva.ch/index.html from www.XN--BCHER-KVA.example.com, not xn--99999a or xn--zz--.",
+	                                     daw::rewrite_direction::to_unicode, out );
+	BOOST_REQUIRE_MESSAGE( out == "GET http://bücher.ch/index.html from www.BüCHER.example.com, not xn--99999a or xn--zz--.", out );
+	BOOST_REQUIRE( stats.rewritten == 2 );
+
+	// A label that decodes to a full stop would display as two labels, so it is left alone
+	out.clear( );
+	daw::rewrite_hostnames( "paypal.xn--com-bz3b.evil.example", daw::rewrite_direction::to_unicode, out );
+	BOOST_REQUIRE_MESSAGE( out == "paypal.xn--com-bz3b.evil.example", out );
+
+	out.clear( );
+	stats = daw::rewrite_hostnames( "mail to user@bücher.ch.\nsee Ünïcödé text and (пример.испытание)",
+	                                daw::rewrite_direction::to_ace, out );
+	BOOST_REQUIRE_MESSAGE( out == "mail to user@xn--bcher-kva.ch.\nsee Ünïcödé text and (xn--e1afmkfd.xn--80akhbyknj4f)", out );
+	BOOST_REQUIRE( stats.rewritten == 2 );
+
+	// Quotes, no-break spaces and other punctuation next to a hostname are not part of it
+	out.clear( );
+	daw::rewrite_hostnames( "see \u201Cbücher.de\u201D now, bücher.de\u00A0ok \u00ABпример.рф\u00BB", daw::rewrite_direction::to_ace, out );
+	BOOST_REQUIRE_MESSAGE( out == "see \u201Cxn--bcher-kva.de\u201D now, xn--bcher-kva.de\u00A0ok \u00ABxn--e1afmkfd.xn--p1ai\u00BB", out );
+	out.clear( );
+	daw::rewrite_hostnames( "x \u201Cxn--bcher-kva.de\u201D y", daw::rewrite_direction::to_ace, out );
+	BOOST_REQUIRE_MESSAGE( out == "x \u201Cxn--bcher-kva.de\u201D y", out );
+	out.clear( );
+	stats = daw::rewrite_hostnames( "x \u201Cxn--bcher-kva.de\u201D y\u00A0xn--bcher-kva.de\u00A0z", daw::rewrite_direction::to_unicode, out );
+	BOOST_REQUIRE_MESSAGE( out == "x \u201Cbücher.de\u201D y\u00A0bücher.de\u00A0z", out );
+	BOOST_REQUIRE( stats.rewritten == 2 );
+
+	// Long runs without candidates and a candidate straddling the 16 byte blocks
+	std::string const padding( 37, ' ' );
+	auto const text = padding + "a.xn--bcher-kva" + padding;
+	out.clear( );
+	daw::rewrite_hostnames( text, daw::rewrite_direction::to_unicode, out );
+	BOOST_REQUIRE( out == padding + "a.bücher" + padding );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_hostname ) {
+	static_assert( sizeof( daw::hostname ) == 256, "hostname should be exactly its inline storage" );
+	static_assert( std::is_trivially_copyable<daw::hostname>::value, "hostname should be trivially copyable" );
+
+	auto const ace = daw::to_puny_code_hostname( "Bücher.example.com" );
+	BOOST_REQUIRE( ace.view( ) == "xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( daw::from_puny_code_hostname( ace.view( ) ).to_string( ) == "bücher.example.com" );
+
+	std::unordered_set<daw::hostname> hosts;
+	hosts.insert( ace );
+	hosts.insert( daw::hostname( "xn--bcher-kva.example.com" ) );
+	hosts.insert( daw::hostname( "example.com" ) );
+	BOOST_REQUIRE( hosts.size( ) == 2 );
+	BOOST_REQUIRE( daw::hostname( "a.com" ) < daw::hostname( "b.com" ) );
+
+	// Repeats of one code point cost one ACE character each but four bytes of UTF-8
+	std::string emoji;
+	for( size_t n = 0; n < 50; ++n ) {
+		emoji += "😀";
+	}
+	auto const long_ace = daw::to_puny_code( emoji + "." + emoji );
+	BOOST_REQUIRE( long_ace.size( ) <= daw::hostname::MAX_SIZE );
+	BOOST_REQUIRE_NO_THROW( daw::hostname{ long_ace } );
+	BOOST_REQUIRE_THROW( daw::from_puny_code_hostname( long_ace ), std::runtime_error );
+	BOOST_REQUIRE_THROW( daw::hostname{ std::string( 256, 'a' ) }, std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_shared_hostname ) {
+	daw::shared_hostname const host( "WWW.Bücher.example.com" );
+	BOOST_REQUIRE( host.ace( ) == "www.xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( host.label_count( ) == 4 );
+	BOOST_REQUIRE( host.label( 1 ) == "xn--bcher-kva" );
+	BOOST_REQUIRE( host.label( 3 ) == "com" );
+
+	auto const copy = host;
+	BOOST_REQUIRE( copy.unicode( ) == "www.bücher.example.com" );
+	// The Unicode form is computed once and shared by the copies
+	BOOST_REQUIRE( host.unicode( ).data( ) == copy.unicode( ).data( ) );
+
+	daw::shared_hostname const from_ace( "www.xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( from_ace == host );
+	BOOST_REQUIRE( std::hash<daw::shared_hostname>( )( from_ace ) == std::hash<daw::shared_hostname>( )( host ) );
+	BOOST_REQUIRE( daw::shared_hostname( "example.com" ) != host );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_label_view ) {
+	auto const labels = []( daw::string_view host ) {
+		std::vector<std::string> forward;
+		for( auto const label : daw::label_view( host ) ) {
+			forward.push_back( label.to_string( ) );
+		}
+		std::vector<std::string> reverse;
+		daw::label_view const view( host );
+		for( auto it = view.rbegin( ); it != view.rend( ); ++it ) {
+			reverse.insert( reverse.begin( ), ( *it ).to_string( ) );
+		}
+		BOOST_REQUIRE( forward == reverse );
+		return forward;
+	};
+	BOOST_REQUIRE( labels( "" ) == std::vector<std::string>{ "" } );
+	BOOST_REQUIRE( ( labels( "www.example.com." ) == std::vector<std::string>{ "www", "example", "com", "" } ) );
+	BOOST_REQUIRE( ( labels( "例え。テスト．jp｡x" ) == std::vector<std::string>{ "例え", "テスト", "jp", "x" } ) );
+	// Separators on both sides of the 16 byte blocks
+	std::string const long_label( 20, 'a' );
+	auto const host = long_label + "。" + long_label + "." + long_label + "｡" + long_label;
+	BOOST_REQUIRE( labels( host ) == std::vector<std::string>( 4, long_label ) );
+
+	BOOST_REQUIRE( daw::to_puny_code( "例え。テスト" ) == "xn--r8jz45g.xn--zckzah" );
+	BOOST_REQUIRE( daw::from_puny_code( "xn--r8jz45g．xn--zckzah" ) == "例え.テスト" );
+}
+
+namespace {
+	// Lower case hexadecimal digits with '_' as the delimiter, for sequences of any 21 bit values
+	struct hex_bootstring_parameters {
+		static constexpr uint32_t const BASE = 16;
+		static constexpr uint32_t const TMIN = 1;
+		static constexpr uint32_t const TMAX = 15;
+		static constexpr uint32_t const SKEW = 38;
+		static constexpr uint32_t const DAMP = 700;
+		static constexpr uint32_t const INITIAL_BIAS = 72;
+		static constexpr uint32_t const INITIAL_N = 128;
+		static constexpr char const DELIMITER = '_';
+
+		static constexpr bool is_basic( uint32_t cp ) noexcept {
+			return cp < 0x80;
+		}
+
+		static constexpr bool is_valid_code_point( uint32_t cp ) noexcept {
+			return cp < 0x200000;
+		}
+
+		static constexpr char encode_digit( uint32_t d ) noexcept {
+			return "0123456789abcdef"[d];
+		}
+
+		static constexpr uint32_t decode_digit( uint32_t c ) noexcept {
+			return daw::parser::in_range( c, '0', '9' ) ? c - '0' : daw::parser::in_range( c, 'a', 'f' ) ? c - 'a' + 10 : BASE;
+		}
+	};
+}    // namespace anonymous
+
+BOOST_AUTO_TEST_CASE( punycode_test_basic_bootstring ) {
+	static_assert( daw::punycode::adapt( 0, 1, true ) == 0, "adapt should be usable at compile time" );
+	static_assert( daw::punycode::threshold( 36, 72 ) == 1, "threshold should be usable at compile time" );
+
+	// RFC 3492 section 7.1 (A) and the case preserving (L), Bootstring does not lower case
+	BOOST_REQUIRE( daw::punycode::encode( U"\u0644\u064A\u0647\u0645\u0627\u0628\u062A\u0643\u0644\u0645\u0648\u0634\u0639\u0631\u0628\u064A\u061F" ) == "egbpdaj6bu4bxfgehfvwxn" );
+	BOOST_REQUIRE( daw::punycode::encode( U"3\u5E74B\u7D44\u91D1\u516B\u5148\u751F" ) == "3B-ww4c5e180e575a65lsy2b" );
+	BOOST_REQUIRE( daw::punycode::decode( "3B-ww4c5e180e575a65lsy2b" ) == U"3\u5E74B\u7D44\u91D1\u516B\u5148\u751F" );
+	BOOST_REQUIRE( daw::punycode::encode( U"abc" ) == "abc-" );
+	BOOST_REQUIRE_THROW( daw::punycode::decode( "99999999999a" ), std::runtime_error );
+
+	using hex_bootstring = daw::basic_bootstring<hex_bootstring_parameters>;
+	for( std::u32string const value : { U"b\u00FCcher", U"\u4F8B\u3048", U"\U0001F984-\U0001F600", U"plain" } ) {
+		auto const encoded = hex_bootstring::encode( value );
+		BOOST_REQUIRE( std::all_of( encoded.begin( ), encoded.end( ), []( char c ) { return c < 0x80; } ) );
+		BOOST_REQUIRE( hex_bootstring::decode( encoded ) == value );
+	}
+	BOOST_REQUIRE( hex_bootstring::encode( U"b\u00FCcher" ) != daw::punycode::encode( U"b\u00FCcher" ) );
+	// Which code points decode is up to the parameters, Punycode only produces Unicode scalar values
+	std::u32string const surrogate( 1, static_cast<char32_t>( 0xD800 ) );
+	BOOST_REQUIRE( hex_bootstring::decode( hex_bootstring::encode( surrogate ) ) == surrogate );
+	BOOST_REQUIRE_THROW( daw::punycode::decode( daw::punycode::encode( surrogate ) ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_hostname_dictionary ) {
+	// Enough names for many blocks, with zones that share prefixes such as example and example-a
+	std::vector<std::string> hostnames = { "Bücher.example.com", "example.com", "www.example.com", "example-a.com",
+	                                       "mail.example-a.com", "例え.テスト", "example.com.", "bad..", "" };
+	for( size_t n = 0; n < 500; ++n ) {
+		hostnames.push_back( "host" + std::to_string( n ) + ".zone" + std::to_string( n % 7 ) + ".example.com" );
+		hostnames.push_back( "www.name" + std::to_string( n ) + ".org" );
+	}
+	daw::write_hostname_dictionary( hostnames, "puny_coder_test.dict" );
+	auto const dictionary = daw::hostname_dictionary::open( "puny_coder_test.dict" );
+	BOOST_REQUIRE( dictionary.verify( ) );
+
+	std::vector<std::string> names;
+	for( auto const name : dictionary ) {
+		names.push_back( name.to_string( ) );
+	}
+	BOOST_REQUIRE( names.size( ) == dictionary.size( ) );
+	BOOST_REQUIRE( dictionary.size( ) == 1006 );
+	for( size_t rank = 0; rank < names.size( ); ++rank ) {
+		BOOST_REQUIRE( dictionary.at( rank ) == names[rank] );
+		BOOST_REQUIRE( dictionary.rank( names[rank] ) == rank );
+	}
+	BOOST_REQUIRE_THROW( dictionary.at( names.size( ) ), std::out_of_range );
+
+	size_t rank = 0;
+	BOOST_REQUIRE( dictionary.find( "Bücher.Example.com", rank ) );
+	BOOST_REQUIRE( names[rank] == "xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( dictionary.contains( "例え.テスト" ) );
+	BOOST_REQUIRE( !dictionary.contains( "missing.example.com" ) );
+	BOOST_REQUIRE( dictionary.rank( "Example.com" ) == dictionary.size( ) );
+
+	// Canonical order keeps a zone and everything below it together
+	auto const zone = dictionary.suffix_range( "example.com" );
+	std::vector<std::string> in_zone;
+	for( auto it = zone.first; it != zone.second; ++it ) {
+		in_zone.push_back( ( *it ).to_string( ) );
+	}
+	BOOST_REQUIRE( in_zone.size( ) == 503 );
+	BOOST_REQUIRE( in_zone.front( ) == "example.com" );
+	BOOST_REQUIRE( std::all_of( in_zone.begin( ), in_zone.end( ), []( std::string const & name ) {
+		return name == "example.com" || ( name.size( ) > 12 && name.compare( name.size( ) - 12, 12, ".example.com" ) == 0 );
+	} ) );
+	BOOST_REQUIRE( std::distance( dictionary.suffix_range( "zone3.example.com" ).first, dictionary.suffix_range( "zone3.example.com" ).second ) == 71 );
+	BOOST_REQUIRE( dictionary.suffix_range( "example-b.com" ).first == dictionary.suffix_range( "example-b.com" ).second );
+
+	size_t www = 0;
+	dictionary.for_each_prefix( "www.", [&]( daw::string_view ) { ++www; } );
+	BOOST_REQUIRE( www == 501 );
+
+	// Runs that never end are cut off at the data section, or rejected when nothing ends them.  The data offset is at
+	// byte 48 of the header and the data is followed by 8 bytes of padding
+	std::string bytes;
+	{
+		std::ifstream in( "puny_coder_test.dict", std::ios::binary );
+		bytes.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>( ) );
+	}
+	uint64_t data_offset = 0;
+	std::memcpy( &data_offset, bytes.data( ) + 48, sizeof( data_offset ) );
+	auto const data_end = bytes.size( ) - 8;
+	for( auto n = data_offset; n + 1 < data_end; ++n ) {
+		bytes[n] = static_cast<char>( bytes[n] & 0x7F );
+	}
+	auto const write_bytes = [&bytes]( ) {
+		std::ofstream out( "puny_coder_test_corrupt.dict", std::ios::binary | std::ios::trunc );
+		out.write( bytes.data( ), static_cast<std::streamsize>( bytes.size( ) ) );
+	};
+	write_bytes( );
+	{
+		auto const corrupt = daw::hostname_dictionary::open( "puny_coder_test_corrupt.dict" );
+		BOOST_REQUIRE( !corrupt.verify( ) );
+		BOOST_REQUIRE( std::distance( corrupt.begin( ), corrupt.end( ) ) == 0 );
+		BOOST_REQUIRE( !corrupt.contains( "Bücher.Example.com" ) );
+		BOOST_REQUIRE( corrupt.rank( "example.com" ) == corrupt.size( ) );
+		BOOST_REQUIRE_THROW( corrupt.at( 0 ), std::runtime_error );
+	}
+	bytes[data_end - 1] = static_cast<char>( bytes[data_end - 1] & 0x7F );
+	write_bytes( );
+	BOOST_REQUIRE_THROW( daw::hostname_dictionary::open( "puny_coder_test_corrupt.dict" ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_packed_hostname ) {
+	static_assert( sizeof( daw::packed_hostname ) == 193, "packed_hostname should be exactly its inline storage" );
+	static_assert( std::is_trivially_copyable<daw::packed_hostname>::value, "packed_hostname should be trivially copyable" );
+
+	auto const packed = daw::to_puny_code_packed( "WWW.Bücher.example.com" );
+	BOOST_REQUIRE( packed.size( ) == 29 );
+	BOOST_REQUIRE( packed.size_bytes( ) == 22 );
+	BOOST_REQUIRE( packed.to_string( ) == "www.xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( packed.to_hostname( ).view( ) == "www.xn--bcher-kva.example.com" );
+	BOOST_REQUIRE( daw::packed_hostname::from_bytes( packed.data( ), packed.size_bytes( ) ) == packed );
+	BOOST_REQUIRE_THROW( daw::packed_hostname( "under_score.com" ), std::runtime_error );
+	BOOST_REQUIRE_THROW( daw::packed_hostname( "Example.com" ), std::runtime_error );
+	uint8_t const bad[] = { 0x00, 0x00, 0x00 };
+	BOOST_REQUIRE_THROW( daw::packed_hostname::from_bytes( bad, sizeof( bad ) ), std::runtime_error );
+
+	// Every size around the 16 character blocks, in the order of the text
+	char const alphabet[] = "-.0123456789abcdefghijklmnopqrstuvwxyz";
+	std::vector<std::string> names;
+	for( size_t size = 0; size < 40; ++size ) {
+		for( size_t n = 0; n < 38; n += 5 ) {
+			std::string name;
+			for( size_t k = 0; k < size; ++k ) {
+				name += alphabet[( n + k * 7 ) % 38];
+			}
+			names.push_back( name );
+		}
+	}
+	std::vector<daw::string_view> views( names.begin( ), names.end( ) );
+	auto const all = daw::pack_hostnames( views );
+	std::unordered_set<daw::packed_hostname> distinct;
+	for( size_t n = 0; n < names.size( ); ++n ) {
+		BOOST_REQUIRE( all[n].to_string( ) == names[n] );
+		BOOST_REQUIRE( all[n].size_bytes( ) == daw::packed_size( names[n].size( ) ) );
+		for( size_t m = 0; m < names.size( ); ++m ) {
+			BOOST_REQUIRE( ( all[n] < all[m] ) == ( names[n] < names[m] ) );
+		}
+		distinct.insert( all[n] );
+	}
+	BOOST_REQUIRE( distinct.size( ) == std::set<std::string>( names.begin( ), names.end( ) ).size( ) );
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_incremental_encoder ) {
+	daw::incremental_encoder encoder;
+	std::string typed = "www.Bücher.example.com";
+	for( size_t n = 0; n < typed.size( ); ) {
+		size_t const size = ( static_cast<unsigned char>( typed[n] ) & 0x80u ) != 0 ? 2 : 1;
+		encoder.append( daw::string_view{ typed.data( ) + n, size } );
+		n += size;
+		BOOST_REQUIRE( encoder.ace( ) == daw::to_puny_code( encoder.text( ) ) );
+	}
+	BOOST_REQUIRE( encoder.ace( ) == "www.xn--bcher-kva.example.com" );
+	// Each keystroke encoded only the label being typed
+	BOOST_REQUIRE( encoder.labels_encoded( ) == 19 );
+	encoder.pop_back( );
+	encoder.pop_back( );
+	encoder.pop_back( );
+	encoder.append( "みんな" );
+	BOOST_REQUIRE( encoder.ace( ) == "www.xn--bcher-kva.example.xn--q9jyb4c" );
+	BOOST_REQUIRE( encoder.labels_encoded( ) == 20 );
+	encoder.assign( "www.bücher.beispiel.xn--q9jyb4c" );
+	BOOST_REQUIRE( encoder.ace( ) == "www.xn--bcher-kva.beispiel.xn--q9jyb4c" );
+	BOOST_REQUIRE( encoder.labels_encoded( ) == 23 );
+
+	// Random edits at the end, including separators and code points from several scripts
+	std::vector<std::string> const pieces = { "a", "Z", "-", ".", "ü", "é", "ж", "み", "例", "😀", "。", "xn--" };
+	std::mt19937 rng( 7 );
+	encoder.clear( );
+	for( size_t n = 0; n < 2000; ++n ) {
+		auto const action = rng( ) % 10;
+		if( action < 6 ) {
+			encoder.append( pieces[rng( ) % pieces.size( )] );
+		} else if( action < 9 ) {
+			encoder.pop_back( );
+		} else {
+			auto text = encoder.text( ).to_string( );
+			auto cut = rng( ) % ( text.size( ) + 1 );
+			while( cut < text.size( ) && ( static_cast<unsigned char>( text[cut] ) & 0xC0u ) == 0x80u ) {
+				--cut;
+			}
+			encoder.assign( text.substr( 0, cut ) + pieces[rng( ) % pieces.size( )] );
+		}
+		BOOST_REQUIRE( encoder.ace( ) == daw::to_puny_code( encoder.text( ) ) );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( punycode_test_chunked_decoder ) {
+	// Encoded payloads with delimiters among the basic code points, and inputs that are not valid
+	std::vector<std::string> payloads = { "", "-", "--", "abc-", "a-b-c-", "bcher-kva", "-> $1.00 <--", "99999999999a", "a-b-zz", "a-b-c!", "99999a", "99999a-b" };
+	// A surrogate and a code point past U+10FFFF
+	payloads.push_back( daw::punycode::encode( std::u32string( 1, static_cast<char32_t>( 0xD800 ) ) ) );
+	payloads.push_back( daw::punycode::encode( std::u32string( 1, static_cast<char32_t>( 0x110000 ) ) ) );
+	std::u32string const alphabet = U"ab-.Züéжみ例\U0001F600";
+	std::mt19937 rng( 3 );
+	for( size_t n = 0; n < 300; ++n ) {
+		std::u32string value;
+		for( auto size = rng( ) % 40; size > 0; --size ) {
+			value += alphabet[rng( ) % alphabet.size( )];
+		}
+		payloads.push_back( daw::punycode::encode( value ) );
+	}
+
+	daw::punycode_decoder decoder;
+	for( auto const & payload : payloads ) {
+		std::u32string expected;
+		std::string expected_error;
+		try {
+			expected = daw::punycode::decode( payload );
+		} catch( std::runtime_error const & ex ) {
+			expected_error = ex.what( );
+		}
+		for( size_t const chunk_size : { 1, 2, 5, 64 } ) {
+			for( size_t pos = 0; pos < payload.size( ); pos += chunk_size ) {
+				decoder.push( daw::string_view{ payload }.substr( pos, chunk_size ) );
+			}
+			std::u32string result;
+			try {
+				decoder.finish( result );
+				BOOST_REQUIRE( expected_error.empty( ) );
+				BOOST_REQUIRE( result == expected );
+			} catch( std::runtime_error const & ex ) {
+				BOOST_REQUIRE( expected_error == ex.what( ) );
+			}
+		}
+	}
+	BOOST_REQUIRE_THROW( daw::punycode::decode( "99999a" ), std::runtime_error );
+}
@@ -0,0 +1,206 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+// Minimal io_uring submission/completion wrapper over the raw system calls so the tools do not need liburing
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace daw {
+	class io_uring_queue {
+		int m_fd = -1;
+		unsigned m_entries = 0;
+		void * m_sq_ptr = MAP_FAILED;
+		size_t m_sq_size = 0;
+		void * m_cq_ptr = MAP_FAILED;
+		size_t m_cq_size = 0;
+		io_uring_sqe * m_sqes = static_cast<io_uring_sqe *>( MAP_FAILED );
+		size_t m_sqes_size = 0;
+
+		unsigned * m_sq_head = nullptr;
+		unsigned * m_sq_tail = nullptr;
+		unsigned * m_sq_mask = nullptr;
+		unsigned * m_sq_array = nullptr;
+		unsigned * m_cq_head = nullptr;
+		unsigned * m_cq_tail = nullptr;
+		unsigned * m_cq_mask = nullptr;
+		io_uring_cqe * m_cqes = nullptr;
+		unsigned m_pending = 0;
+
+		static std::runtime_error error( char const * what ) {
+			return std::runtime_error( std::string( what ) + ": " + std::strerror( errno ) );
+		}
+
+		template<typename T>
+		static T * at( void * base, unsigned offset ) noexcept {
+			return reinterpret_cast<T *>( static_cast<char *>( base ) + offset );
+		}
+
+		static unsigned load_acquire( unsigned const * p ) noexcept {
+			return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+		}
+
+		static void store_release( unsigned * p, unsigned value ) noexcept {
+			__atomic_store_n( p, value, __ATOMIC_RELEASE );
+		}
+
+		void release( ) noexcept {
+			if( m_sqes != MAP_FAILED ) {
+				munmap( m_sqes, m_sqes_size );
+			}
+			if( m_cq_ptr != MAP_FAILED && m_cq_ptr != m_sq_ptr ) {
+				munmap( m_cq_ptr, m_cq_size );
+			}
+			if( m_sq_ptr != MAP_FAILED ) {
+				munmap( m_sq_ptr, m_sq_size );
+			}
+			if( m_fd >= 0 ) {
+				close( m_fd );
+			}
+			m_sqes = static_cast<io_uring_sqe *>( MAP_FAILED );
+			m_sq_ptr = m_cq_ptr = MAP_FAILED;
+			m_fd = -1;
+		}
+
+	public:
+		explicit io_uring_queue( unsigned entries ) {
+			io_uring_params params;
+			std::memset( &params, 0, sizeof( params ) );
+			m_fd = static_cast<int>( syscall( __NR_io_uring_setup, entries, &params ) );
+			if( m_fd < 0 ) {
+				throw error( "io_uring_setup" );
+			}
+			m_entries = params.sq_entries;
+			m_sq_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+			m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+			bool const single_mmap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+			if( single_mmap ) {
+				m_sq_size = m_cq_size = std::max( m_sq_size, m_cq_size );
+			}
+			m_sq_ptr = mmap( nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+			if( m_sq_ptr == MAP_FAILED ) {
+				auto const ex = error( "mmap sq ring" );
+				release( );
+				throw ex;
+			}
+			m_cq_ptr = single_mmap ? m_sq_ptr
+			                       : mmap( nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+			                               IORING_OFF_CQ_RING );
+			m_sqes_size = params.sq_entries * sizeof( io_uring_sqe );
+			m_sqes = static_cast<io_uring_sqe *>(
+			  mmap( nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES ) );
+			if( m_cq_ptr == MAP_FAILED || m_sqes == MAP_FAILED ) {
+				auto const ex = error( "mmap io_uring" );
+				release( );
+				throw ex;
+			}
+			m_sq_head = at<unsigned>( m_sq_ptr, params.sq_off.head );
+			m_sq_tail = at<unsigned>( m_sq_ptr, params.sq_off.tail );
+			m_sq_mask = at<unsigned>( m_sq_ptr, params.sq_off.ring_mask );
+			m_sq_array = at<unsigned>( m_sq_ptr, params.sq_off.array );
+			m_cq_head = at<unsigned>( m_cq_ptr, params.cq_off.head );
+			m_cq_tail = at<unsigned>( m_cq_ptr, params.cq_off.tail );
+			m_cq_mask = at<unsigned>( m_cq_ptr, params.cq_off.ring_mask );
+			m_cqes = at<io_uring_cqe>( m_cq_ptr, params.cq_off.cqes );
+		}
+
+		~io_uring_queue( ) {
+			release( );
+		}
+
+		io_uring_queue( io_uring_queue const & ) = delete;
+		io_uring_queue & operator=( io_uring_queue const & ) = delete;
+
+		void register_buffers( iovec const * buffers, unsigned count ) {
+			if( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers, count ) < 0 ) {
+				throw error( "io_uring_register" );
+			}
+		}
+
+		// Returns nullptr when the submission queue is full
+		io_uring_sqe * get_sqe( ) noexcept {
+			auto const tail = *m_sq_tail + m_pending;
+			if( tail - load_acquire( m_sq_head ) >= m_entries ) {
+				return nullptr;
+			}
+			auto const index = tail & *m_sq_mask;
+			auto sqe = &m_sqes[index];
+			std::memset( sqe, 0, sizeof( *sqe ) );
+			m_sq_array[index] = index;
+			++m_pending;
+			return sqe;
+		}
+
+		static void prep_rw( io_uring_sqe * sqe, uint8_t op, int fd, void const * addr, unsigned size, uint64_t offset,
+		                     uint64_t user_data ) noexcept {
+			sqe->opcode = op;
+			sqe->fd = fd;
+			sqe->addr = reinterpret_cast<uint64_t>( addr );
+			sqe->len = size;
+			sqe->off = offset;
+			sqe->user_data = user_data;
+		}
+
+		// Submits queued entries and optionally waits for at least wait_for completions
+		void submit( unsigned wait_for = 0 ) {
+			auto const to_submit = m_pending;
+			store_release( m_sq_tail, *m_sq_tail + m_pending );
+			m_pending = 0;
+			while( true ) {
+				auto const result = syscall( __NR_io_uring_enter, m_fd, to_submit, wait_for,
+				                             wait_for > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0 );
+				if( result >= 0 ) {
+					return;
+				}
+				if( errno != EINTR ) {
+					throw error( "io_uring_enter" );
+				}
+			}
+		}
+
+		template<typename Function>
+		unsigned for_each_completion( Function func ) {
+			auto head = *m_cq_head;
+			auto const tail = load_acquire( m_cq_tail );
+			unsigned count = 0;
+			for( ; head != tail; ++head, ++count ) {
+				auto const & cqe = m_cqes[head & *m_cq_mask];
+				func( cqe.user_data, cqe.res );
+			}
+			store_release( m_cq_head, head );
+			return count;
+		}
+	};
+}    // namespace daw
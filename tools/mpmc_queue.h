@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace daw {
+	// Bounded lock-free multi-producer/multi-consumer queue (D. Vyukov's sequenced ring).  Capacity must be a power of 2
+	template<typename T>
+	class mpmc_queue {
+		struct cell_t {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		static constexpr size_t const CACHE_LINE = 64;
+
+		std::unique_ptr<cell_t[]> m_cells;
+		size_t m_mask;
+		alignas( CACHE_LINE ) std::atomic<size_t> m_enqueue_pos;
+		alignas( CACHE_LINE ) std::atomic<size_t> m_dequeue_pos;
+
+	public:
+		explicit mpmc_queue( size_t capacity )
+		  : m_cells{ new cell_t[capacity] }, m_mask{ capacity - 1 }, m_enqueue_pos{ 0 }, m_dequeue_pos{ 0 } {
+			if( capacity < 2 || ( capacity & ( capacity - 1 ) ) != 0 ) {
+				throw std::invalid_argument( "Queue capacity must be a power of 2" );
+			}
+			for( size_t n = 0; n < capacity; ++n ) {
+				m_cells[n].sequence.store( n, std::memory_order_relaxed );
+			}
+		}
+
+		mpmc_queue( mpmc_queue const & ) = delete;
+		mpmc_queue & operator=( mpmc_queue const & ) = delete;
+
+		bool try_push( T && value ) {
+			auto pos = m_enqueue_pos.load( std::memory_order_relaxed );
+			while( true ) {
+				auto & cell = m_cells[pos & m_mask];
+				auto const seq = cell.sequence.load( std::memory_order_acquire );
+				auto const diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos );
+				if( diff == 0 ) {
+					if( m_enqueue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+						cell.value = std::move( value );
+						cell.sequence.store( pos + 1, std::memory_order_release );
+						return true;
+					}
+				} else if( diff < 0 ) {
+					return false;
+				} else {
+					pos = m_enqueue_pos.load( std::memory_order_relaxed );
+				}
+			}
+		}
+
+		bool try_pop( T & value ) {
+			auto pos = m_dequeue_pos.load( std::memory_order_relaxed );
+			while( true ) {
+				auto & cell = m_cells[pos & m_mask];
+				auto const seq = cell.sequence.load( std::memory_order_acquire );
+				auto const diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos + 1 );
+				if( diff == 0 ) {
+					if( m_dequeue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+						value = std::move( cell.value );
+						cell.sequence.store( pos + m_mask + 1, std::memory_order_release );
+						return true;
+					}
+				} else if( diff < 0 ) {
+					return false;
+				} else {
+					pos = m_dequeue_pos.load( std::memory_order_relaxed );
+				}
+			}
+		}
+
+		bool empty( ) const noexcept {
+			return m_enqueue_pos.load( std::memory_order_relaxed ) == m_dequeue_pos.load( std::memory_order_relaxed );
+		}
+	};
+}    // namespace daw
@@ -0,0 +1,536 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Converts a file of hostnames, one per line, with to_puny_code/from_puny_code.  I/O is done either with io_uring
+// (registered read buffers with several reads in flight) or with plain read( )/write( ).  In both cases line aligned
+// blocks are converted on worker threads while further I/O is in progress and written back in input order
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "io_uring.h"
+#include "mpmc_queue.h"
+#include "puny_coder.h"
+
+namespace {
+	enum class conversion_mode { automatic, encode, decode };
+	enum class io_mode { uring, posix };
+
+	constexpr size_t const CHUNK_SIZE = 1u << 20;
+	constexpr unsigned const READS_IN_FLIGHT = 8;
+	constexpr unsigned const WRITES_IN_FLIGHT = 8;
+
+	struct run_stats {
+		size_t bytes_in = 0;
+		size_t bytes_out = 0;
+		size_t errors = 0;
+		double seconds = 0.0;
+	};
+
+	void convert_line( daw::string_view line, conversion_mode mode, std::string & out, size_t & errors ) {
+		try {
+			switch( mode ) {
+			case conversion_mode::encode:
+				out += daw::to_puny_code( line );
+				return;
+			case conversion_mode::decode:
+				out += daw::from_puny_code( line );
+				return;
+			case conversion_mode::automatic:
+				switch( daw::classify_hostname( line ).type ) {
+				case daw::hostname_class::contains_non_ascii:
+					out += daw::to_puny_code( line );
+					return;
+				case daw::hostname_class::contains_ace:
+					out += daw::from_puny_code( line );
+					return;
+				default:
+					out.append( line.data( ), line.size( ) );
+					return;
+				}
+			}
+		} catch( std::exception const & ) {
+			++errors;
+			out.append( line.data( ), line.size( ) );
+		}
+	}
+
+	struct block_t {
+		size_t index = 0;
+		std::string text;
+	};
+
+	// Converts blocks on worker threads; results are collected by block index so they can be written in order
+	class converter_pool {
+		conversion_mode m_mode;
+		int m_notify_fd;
+		daw::mpmc_queue<block_t> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::map<size_t, std::string> m_done;
+		size_t m_errors = 0;
+		bool m_stop = false;
+		std::vector<std::thread> m_threads;
+
+		void run( ) {
+			while( true ) {
+				block_t block;
+				if( !m_queue.try_pop( block ) ) {
+					std::unique_lock<std::mutex> lock( m_mutex );
+					if( m_stop ) {
+						return;
+					}
+					m_cv.wait_for( lock, std::chrono::milliseconds( 1 ) );
+					continue;
+				}
+				std::string out;
+				out.reserve( block.text.size( ) + block.text.size( ) / 4 );
+				size_t errors = 0;
+				daw::string_view text{ block.text.data( ), block.text.size( ) };
+				while( !text.empty( ) ) {
+					auto const eol = std::find( text.begin( ), text.end( ), '\n' );
+					auto const size = static_cast<size_t>( eol - text.begin( ) );
+					if( size > 0 ) {
+						convert_line( text.substr( 0, size ), m_mode, out, errors );
+					}
+					if( eol != text.end( ) ) {
+						out += '\n';
+						text.remove_prefix( size + 1 );
+					} else {
+						break;
+					}
+				}
+				{
+					std::lock_guard<std::mutex> lock( m_mutex );
+					m_done[block.index] = std::move( out );
+					m_errors += errors;
+				}
+				m_cv.notify_all( );
+				if( m_notify_fd >= 0 ) {
+					uint64_t const one = 1;
+					if( write( m_notify_fd, &one, sizeof( one ) ) < 0 ) {
+						std::cerr << "eventfd write failed\n";
+					}
+				}
+			}
+		}
+
+	public:
+		converter_pool( conversion_mode mode, size_t thread_count, int notify_fd )
+		  : m_mode( mode ), m_notify_fd( notify_fd ), m_queue( 1024 ) {
+			for( size_t n = 0; n < thread_count; ++n ) {
+				m_threads.emplace_back( [this]( ) { run( ); } );
+			}
+		}
+
+		~converter_pool( ) {
+			{
+				std::lock_guard<std::mutex> lock( m_mutex );
+				m_stop = true;
+			}
+			m_cv.notify_all( );
+			for( auto & t : m_threads ) {
+				t.join( );
+			}
+		}
+
+		void submit( size_t index, std::string text ) {
+			block_t block{ index, std::move( text ) };
+			while( !m_queue.try_push( std::move( block ) ) ) {
+				std::this_thread::yield( );
+			}
+			m_cv.notify_one( );
+		}
+
+		bool try_take( size_t index, std::string & out ) {
+			std::lock_guard<std::mutex> lock( m_mutex );
+			auto it = m_done.find( index );
+			if( it == m_done.end( ) ) {
+				return false;
+			}
+			out = std::move( it->second );
+			m_done.erase( it );
+			return true;
+		}
+
+		std::string take( size_t index ) {
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_cv.wait( lock, [&]( ) { return m_done.count( index ) != 0; } );
+			auto result = std::move( m_done[index] );
+			m_done.erase( index );
+			return result;
+		}
+
+		size_t errors( ) {
+			std::lock_guard<std::mutex> lock( m_mutex );
+			return m_errors;
+		}
+	};
+
+	// Splits a stream of chunks into blocks that end on a line boundary
+	class line_splitter {
+		std::string m_carry;
+
+	public:
+		std::string next_block( char const * data, size_t size ) {
+			auto const last_nl = std::find( std::reverse_iterator<char const *>( data + size ),
+			                                std::reverse_iterator<char const *>( data ), '\n' );
+			auto const cut = static_cast<size_t>( last_nl.base( ) - data );
+			std::string result = std::move( m_carry );
+			result.append( data, cut );
+			m_carry.assign( data + cut, size - cut );
+			return result;
+		}
+
+		std::string finish( ) {
+			return std::move( m_carry );
+		}
+	};
+
+	void write_all( int fd, std::string const & data ) {
+		size_t pos = 0;
+		while( pos < data.size( ) ) {
+			auto const count = write( fd, data.data( ) + pos, data.size( ) - pos );
+			if( count < 0 ) {
+				if( errno == EINTR ) {
+					continue;
+				}
+				throw std::runtime_error( std::string( "write: " ) + std::strerror( errno ) );
+			}
+			pos += static_cast<size_t>( count );
+		}
+	}
+
+	void convert_posix( int in_fd, int out_fd, converter_pool & pool, size_t max_outstanding, run_stats & stats ) {
+		std::unique_ptr<char[]> buffer( new char[CHUNK_SIZE] );
+		line_splitter splitter;
+		size_t submitted = 0;
+		size_t written = 0;
+		auto const write_block = [&]( std::string const & out ) {
+			write_all( out_fd, out );
+			stats.bytes_out += out.size( );
+			++written;
+		};
+		while( true ) {
+			auto const count = read( in_fd, buffer.get( ), CHUNK_SIZE );
+			if( count < 0 ) {
+				if( errno == EINTR ) {
+					continue;
+				}
+				throw std::runtime_error( std::string( "read: " ) + std::strerror( errno ) );
+			}
+			if( count == 0 ) {
+				break;
+			}
+			stats.bytes_in += static_cast<size_t>( count );
+			pool.submit( submitted++, splitter.next_block( buffer.get( ), static_cast<size_t>( count ) ) );
+			std::string out;
+			while( written < submitted && pool.try_take( written, out ) ) {
+				write_block( out );
+			}
+			while( submitted - written >= max_outstanding ) {
+				write_block( pool.take( written ) );
+			}
+		}
+		pool.submit( submitted++, splitter.finish( ) );
+		while( written < submitted ) {
+			write_block( pool.take( written ) );
+		}
+	}
+
+	void convert_uring( int in_fd, int out_fd, int notify_fd, converter_pool & pool, size_t max_outstanding,
+	                    run_stats & stats ) {
+		enum : uint64_t { READ_TAG = 1ULL << 62, WRITE_TAG = 2ULL << 62, NOTIFY_TAG = 3ULL << 62, TAG_MASK = 3ULL << 62 };
+
+		struct stat st;
+		if( fstat( in_fd, &st ) < 0 ) {
+			throw std::runtime_error( std::string( "fstat: " ) + std::strerror( errno ) );
+		}
+		auto const file_size = static_cast<size_t>( st.st_size );
+
+		std::unique_ptr<char[]> storage( new char[READS_IN_FLIGHT * CHUNK_SIZE] );
+		std::vector<iovec> buffers( READS_IN_FLIGHT );
+		for( size_t n = 0; n < READS_IN_FLIGHT; ++n ) {
+			buffers[n].iov_base = storage.get( ) + n * CHUNK_SIZE;
+			buffers[n].iov_len = CHUNK_SIZE;
+		}
+
+		struct read_state {
+			size_t chunk = 0;
+			size_t size = 0;
+			size_t filled = 0;
+		};
+		std::vector<read_state> reads( READS_IN_FLIGHT );
+		std::vector<unsigned> free_buffers;
+		for( unsigned n = READS_IN_FLIGHT; n > 0; --n ) {
+			free_buffers.push_back( n - 1 );
+		}
+		std::map<size_t, unsigned> completed_chunks;
+		auto const chunk_count = ( file_size + CHUNK_SIZE - 1 ) / CHUNK_SIZE;
+		size_t next_chunk = 0;
+		size_t next_split = 0;
+
+		line_splitter splitter;
+		size_t submitted = 0;
+		size_t written = 0;
+		size_t write_offset = 0;
+		std::map<uint64_t, std::string> writes_in_flight;
+		std::map<uint64_t, std::pair<size_t, size_t>> write_progress; // offset, bytes done
+		uint64_t next_write_id = 0;
+		uint64_t notify_value = 0;
+		bool finished_input = chunk_count == 0;
+
+		// Declared after everything the kernel reads or writes, so that when an exception unwinds this frame the ring
+		// and its outstanding requests go before the buffers they point to
+		daw::io_uring_queue ring( 2 * ( READS_IN_FLIGHT + WRITES_IN_FLIGHT ) );
+		ring.register_buffers( buffers.data( ), READS_IN_FLIGHT );
+
+		// The ring holds every request this can have outstanding, but submit and retry rather than trust that
+		auto const next_sqe = [&ring]( ) {
+			auto sqe = ring.get_sqe( );
+			if( sqe == nullptr ) {
+				ring.submit( );
+				sqe = ring.get_sqe( );
+				if( sqe == nullptr ) {
+					throw std::runtime_error( "io_uring submission queue is full" );
+				}
+			}
+			return sqe;
+		};
+
+		auto const queue_read = [&]( unsigned buf ) {
+			auto const & r = reads[buf];
+			auto sqe = next_sqe( );
+			daw::io_uring_queue::prep_rw( sqe, IORING_OP_READ_FIXED, in_fd, storage.get( ) + buf * CHUNK_SIZE + r.filled,
+			                              static_cast<unsigned>( r.size - r.filled ), r.chunk * CHUNK_SIZE + r.filled,
+			                              READ_TAG | buf );
+			sqe->buf_index = static_cast<uint16_t>( buf );
+		};
+		auto const queue_write = [&]( uint64_t id ) {
+			auto const & data = writes_in_flight[id];
+			auto const & progress = write_progress[id];
+			auto sqe = next_sqe( );
+			daw::io_uring_queue::prep_rw( sqe, IORING_OP_WRITE, out_fd, data.data( ) + progress.second,
+			                              static_cast<unsigned>( data.size( ) - progress.second ),
+			                              progress.first + progress.second, WRITE_TAG | id );
+		};
+		auto const queue_notify = [&]( ) {
+			auto sqe = next_sqe( );
+			daw::io_uring_queue::prep_rw( sqe, IORING_OP_READ, notify_fd, &notify_value, sizeof( notify_value ), 0,
+			                              NOTIFY_TAG );
+		};
+		queue_notify( );
+
+		while( !finished_input || written < submitted || !writes_in_flight.empty( ) ) {
+			// Keep the read pipeline full
+			while( next_chunk < chunk_count && !free_buffers.empty( ) && submitted - written < max_outstanding ) {
+				auto const buf = free_buffers.back( );
+				free_buffers.pop_back( );
+				reads[buf] = read_state{ next_chunk, std::min( CHUNK_SIZE, file_size - next_chunk * CHUNK_SIZE ), 0 };
+				++next_chunk;
+				queue_read( buf );
+			}
+			// Hand completed chunks to the workers in order
+			for( auto it = completed_chunks.find( next_split ); it != completed_chunks.end( );
+			     it = completed_chunks.find( next_split ) ) {
+				auto const buf = it->second;
+				pool.submit( submitted++, splitter.next_block( storage.get( ) + buf * CHUNK_SIZE, reads[buf].size ) );
+				free_buffers.push_back( buf );
+				completed_chunks.erase( it );
+				if( ++next_split == chunk_count ) {
+					pool.submit( submitted++, splitter.finish( ) );
+					finished_input = true;
+				}
+			}
+			// Write converted blocks in order
+			std::string out;
+			while( writes_in_flight.size( ) < WRITES_IN_FLIGHT && written < submitted && pool.try_take( written, out ) ) {
+				++written;
+				if( out.empty( ) ) {
+					continue;
+				}
+				auto const id = next_write_id++;
+				write_progress[id] = { write_offset, 0 };
+				write_offset += out.size( );
+				stats.bytes_out += out.size( );
+				writes_in_flight[id] = std::move( out );
+				queue_write( id );
+			}
+			if( finished_input && written == submitted && writes_in_flight.empty( ) ) {
+				break;
+			}
+
+			ring.submit( 1 );
+			ring.for_each_completion( [&]( uint64_t user_data, int32_t result ) {
+				if( result < 0 ) {
+					errno = -result;
+					throw std::runtime_error( std::string( "io_uring operation: " ) + std::strerror( errno ) );
+				}
+				auto const id = user_data & ~TAG_MASK;
+				switch( user_data & TAG_MASK ) {
+				case READ_TAG: {
+					auto & r = reads[id];
+					r.filled += static_cast<size_t>( result );
+					stats.bytes_in += static_cast<size_t>( result );
+					if( result == 0 || r.filled == r.size ) {
+						r.size = r.filled;
+						completed_chunks[r.chunk] = static_cast<unsigned>( id );
+					} else {
+						queue_read( static_cast<unsigned>( id ) );
+					}
+					break;
+				}
+				case WRITE_TAG: {
+					auto & progress = write_progress[id];
+					progress.second += static_cast<size_t>( result );
+					if( progress.second == writes_in_flight[id].size( ) ) {
+						writes_in_flight.erase( id );
+						write_progress.erase( id );
+					} else {
+						queue_write( id );
+					}
+					break;
+				}
+				case NOTIFY_TAG:
+					queue_notify( );
+					break;
+				}
+			} );
+		}
+		if( ftruncate( out_fd, static_cast<off_t>( write_offset ) ) < 0 ) {
+			throw std::runtime_error( std::string( "ftruncate: " ) + std::strerror( errno ) );
+		}
+	}
+
+	run_stats convert_file( std::string const & in_path, std::string const & out_path, conversion_mode mode, io_mode io,
+	                        size_t thread_count ) {
+		auto const in_fd = open( in_path.c_str( ), O_RDONLY | O_CLOEXEC );
+		if( in_fd < 0 ) {
+			throw std::runtime_error( "Could not open " + in_path );
+		}
+		auto const out_fd = open( out_path.c_str( ), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+		if( out_fd < 0 ) {
+			close( in_fd );
+			throw std::runtime_error( "Could not open " + out_path );
+		}
+		auto const notify_fd = io == io_mode::uring ? eventfd( 0, EFD_CLOEXEC ) : -1;
+		run_stats stats;
+		auto const start = std::chrono::steady_clock::now( );
+		try {
+			converter_pool pool( mode, thread_count, notify_fd );
+			auto const max_outstanding = 2 * thread_count + READS_IN_FLIGHT;
+			if( io == io_mode::uring ) {
+				convert_uring( in_fd, out_fd, notify_fd, pool, max_outstanding, stats );
+			} else {
+				convert_posix( in_fd, out_fd, pool, max_outstanding, stats );
+			}
+			stats.errors = pool.errors( );
+		} catch( ... ) {
+			close( in_fd );
+			close( out_fd );
+			if( notify_fd >= 0 ) {
+				close( notify_fd );
+			}
+			throw;
+		}
+		std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now( ) - start;
+		stats.seconds = elapsed.count( );
+		close( in_fd );
+		close( out_fd );
+		if( notify_fd >= 0 ) {
+			close( notify_fd );
+		}
+		return stats;
+	}
+
+	void report( char const * name, run_stats const & stats ) {
+		auto const mb = static_cast<double>( stats.bytes_in ) / ( 1024.0 * 1024.0 );
+		std::cout << name << ": " << stats.bytes_in << " bytes in, " << stats.bytes_out << " bytes out, " << stats.errors
+		          << " errors, " << stats.seconds << "s, " << mb / stats.seconds << " MB/s\n";
+	}
+
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name
+		          << " [--encode|--decode|--auto] [--io uring|posix|compare] [--threads N] INPUT OUTPUT\n"
+		             "  --compare runs both I/O paths on the same files; drop the page cache between runs for cold numbers\n";
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	auto mode = conversion_mode::automatic;
+	std::string io = "uring";
+	size_t thread_count = std::max( 1u, std::thread::hardware_concurrency( ) );
+	std::vector<std::string> paths;
+	for( int n = 1; n < argc; ++n ) {
+		std::string const arg = argv[n];
+		if( arg == "--encode" ) {
+			mode = conversion_mode::encode;
+		} else if( arg == "--decode" ) {
+			mode = conversion_mode::decode;
+		} else if( arg == "--auto" ) {
+			mode = conversion_mode::automatic;
+		} else if( arg == "--io" && n + 1 < argc ) {
+			io = argv[++n];
+		} else if( arg == "--threads" && n + 1 < argc ) {
+			thread_count = std::max( size_t{ 1 }, static_cast<size_t>( std::stoul( argv[++n] ) ) );
+		} else if( !arg.empty( ) && arg[0] != '-' ) {
+			paths.push_back( arg );
+		} else {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+	if( paths.size( ) != 2 || ( io != "uring" && io != "posix" && io != "compare" ) ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	try {
+		if( io == "posix" || io == "compare" ) {
+			report( "read/write", convert_file( paths[0], paths[1], mode, io_mode::posix, thread_count ) );
+		}
+		if( io == "uring" || io == "compare" ) {
+			report( "io_uring", convert_file( paths[0], paths[1], mode, io_mode::uring, thread_count ) );
+		}
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Builds, verifies and queries front coded hostname dictionaries (see puny_coder_dictionary.h)
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "puny_coder_dictionary.h"
+
+namespace {
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " build HOSTNAMES_FILE DICTIONARY_FILE\n"
+		          << "       " << name << " verify DICTIONARY_FILE\n"
+		          << "       " << name << " lookup DICTIONARY_FILE HOSTNAME...\n"
+		          << "       " << name << " list DICTIONARY_FILE [ZONE]\n";
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	if( argc < 3 ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	std::string const command = argv[1];
+	try {
+		if( command == "build" && argc == 4 ) {
+			std::ifstream in( argv[2] );
+			if( !in ) {
+				std::cerr << "Could not open " << argv[2] << '\n';
+				return EXIT_FAILURE;
+			}
+			std::vector<std::string> hostnames;
+			size_t text_size = 0;
+			std::string line;
+			while( std::getline( in, line ) ) {
+				if( !line.empty( ) && line.back( ) == '\r' ) {
+					line.pop_back( );
+				}
+				text_size += line.size( ) + 1;
+				hostnames.push_back( std::move( line ) );
+			}
+			daw::write_hostname_dictionary( hostnames, argv[3] );
+			auto const dictionary = daw::hostname_dictionary::open( argv[3] );
+			std::cout << "Wrote " << dictionary.size( ) << " hostnames in " << dictionary.size_bytes( ) << " bytes to "
+			          << argv[3] << " from " << text_size << " bytes of text\n";
+		} else if( command == "verify" && argc == 3 ) {
+			auto const dictionary = daw::hostname_dictionary::open( argv[2] );
+			if( !dictionary.verify( ) ) {
+				std::cerr << argv[2] << ": checksum mismatch\n";
+				return EXIT_FAILURE;
+			}
+			std::cout << argv[2] << ": ok, " << dictionary.size( ) << " hostnames\n";
+		} else if( command == "lookup" && argc >= 4 ) {
+			auto const dictionary = daw::hostname_dictionary::open( argv[2] );
+			for( int n = 3; n < argc; ++n ) {
+				size_t rank = 0;
+				if( dictionary.find( argv[n], rank ) ) {
+					std::cout << argv[n] << " -> " << rank << '\n';
+				} else {
+					std::cout << argv[n] << " not in dictionary\n";
+				}
+			}
+		} else if( command == "list" && ( argc == 3 || argc == 4 ) ) {
+			auto const dictionary = daw::hostname_dictionary::open( argv[2] );
+			auto const range = dictionary.suffix_range( argc == 4 ? argv[3] : "" );
+			for( auto it = range.first; it != range.second; ++it ) {
+				std::cout << *it << '\n';
+			}
+		} else {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		}
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Builds and queries IDN membership filters (see puny_coder_filter.h)
+
+#include <chrono>
+#include <stdexcept>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "puny_coder_filter.h"
+
+namespace {
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " build HOSTNAMES_FILE FILTER_FILE\n"
+		          << "       " << name << " query FILTER_FILE HOSTNAMES_FILE\n";
+	}
+
+	std::vector<std::string> read_lines( char const * path ) {
+		std::ifstream in( path );
+		if( !in ) {
+			throw std::runtime_error( std::string( "Could not open " ) + path );
+		}
+		std::vector<std::string> result;
+		std::string line;
+		while( std::getline( in, line ) ) {
+			if( !line.empty( ) && line.back( ) == '\r' ) {
+				line.pop_back( );
+			}
+			if( !line.empty( ) ) {
+				result.push_back( std::move( line ) );
+			}
+		}
+		return result;
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	if( argc != 4 ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	std::string const command = argv[1];
+	try {
+		if( command == "build" ) {
+			auto const filter = daw::idn_filter::build( read_lines( argv[2] ) );
+			filter.save( argv[3] );
+			std::cout << "Wrote " << filter.size( ) << " keys in " << filter.size_in_bytes( ) << " bytes to " << argv[3]
+			          << '\n';
+		} else if( command == "query" ) {
+			auto const filter = daw::idn_filter::open( argv[2] );
+			auto const hostnames = read_lines( argv[3] );
+			size_t positives = 0;
+			auto const start = std::chrono::steady_clock::now( );
+			for( auto const & host : hostnames ) {
+				positives += filter.may_contain( host ) ? 1 : 0;
+			}
+			std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now( ) - start;
+			std::cout << positives << " of " << hostnames.size( ) << " may be present, "
+			          << elapsed.count( ) / static_cast<double>( hostnames.size( ) ) << "ns per query\n";
+		} else {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		}
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
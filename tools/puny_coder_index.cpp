@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Builds, verifies and queries memory mapped conversion indexes (see puny_coder_index.h)
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "puny_coder.h"
+#include "puny_coder_index.h"
+
+namespace {
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " build HOSTNAMES_FILE INDEX_FILE\n"
+		          << "       " << name << " verify INDEX_FILE\n"
+		          << "       " << name << " lookup INDEX_FILE HOSTNAME...\n";
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	if( argc < 3 ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	std::string const command = argv[1];
+	try {
+		if( command == "build" && argc == 4 ) {
+			std::ifstream in( argv[2] );
+			if( !in ) {
+				std::cerr << "Could not open " << argv[2] << '\n';
+				return EXIT_FAILURE;
+			}
+			std::vector<std::string> hostnames;
+			std::string line;
+			while( std::getline( in, line ) ) {
+				if( !line.empty( ) && line.back( ) == '\r' ) {
+					line.pop_back( );
+				}
+				hostnames.push_back( std::move( line ) );
+			}
+			daw::write_conversion_index( hostnames, argv[3] );
+			std::cout << "Wrote " << daw::conversion_index::open( argv[3] ).size( ) << " conversions to " << argv[3] << '\n';
+		} else if( command == "verify" && argc == 3 ) {
+			auto const index = daw::conversion_index::open( argv[2] );
+			if( !index.verify( ) ) {
+				std::cerr << argv[2] << ": checksum mismatch\n";
+				return EXIT_FAILURE;
+			}
+			std::cout << argv[2] << ": ok, " << index.size( ) << " conversions\n";
+		} else if( command == "lookup" && argc >= 4 ) {
+			auto const index = daw::conversion_index::open( argv[2] );
+			for( int n = 3; n < argc; ++n ) {
+				daw::string_view result;
+				if( index.find_ace( argv[n], result ) || index.find_unicode( argv[n], result ) ) {
+					std::cout << argv[n] << " -> " << result << '\n';
+				} else {
+					std::cout << argv[n] << " not in index\n";
+				}
+			}
+		} else {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		}
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Rewrites the hostnames found in free text such as logs (see puny_coder_rewrite.h).  The input is cut into line
+// aligned blocks that are rewritten on worker threads and written out in input order
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "puny_coder_rewrite.h"
+
+namespace {
+	constexpr size_t const BLOCK_SIZE = 1u << 20;
+	constexpr size_t const MAX_LINE_SIZE = 64 * BLOCK_SIZE;
+
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " [--to-unicode|--to-ace] [--threads N] [INPUT [OUTPUT]]\n"
+		          << "INPUT and OUTPUT default to stdin and stdout\n";
+	}
+
+	struct block_result {
+		std::string text;
+		daw::rewrite_stats stats;
+	};
+
+	block_result rewrite_block( std::string const & block, daw::rewrite_direction direction ) {
+		block_result result;
+		result.text.reserve( block.size( ) + block.size( ) / 8 );
+		result.stats = daw::rewrite_hostnames( daw::string_view{ block.data( ), block.size( ) }, direction, result.text );
+		return result;
+	}
+
+	// Reads BLOCK_SIZE bytes at a time and returns the text up to and including the last newline, keeping the rest in
+	// carry, so a hostname is never split between blocks.  Reading goes on until a newline or the end of the input, up
+	// to MAX_LINE_SIZE bytes
+	bool next_block( std::istream & in, char * buffer, std::string & carry, std::string & block ) {
+		block = std::move( carry );
+		carry.clear( );
+		while( true ) {
+			in.read( buffer, BLOCK_SIZE );
+			auto const count = static_cast<size_t>( in.gcount( ) );
+			if( count == 0 ) {
+				return !block.empty( );
+			}
+			auto const data = buffer;
+			auto const last_nl = std::find( std::reverse_iterator<char const *>( data + count ),
+			                                std::reverse_iterator<char const *>( data ), '\n' );
+			auto const cut = static_cast<size_t>( last_nl.base( ) - data );
+			block.append( data, cut );
+			if( cut > 0 ) {
+				carry.assign( data + cut, count - cut );
+				return true;
+			}
+			block.append( data, count );
+			if( block.size( ) > MAX_LINE_SIZE ) {
+				throw std::runtime_error( "A line is longer than " + std::to_string( MAX_LINE_SIZE ) + " bytes" );
+			}
+		}
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	auto direction = daw::rewrite_direction::to_unicode;
+	size_t thread_count = std::max( 1u, std::thread::hardware_concurrency( ) );
+	std::vector<std::string> paths;
+	for( int n = 1; n < argc; ++n ) {
+		std::string const arg = argv[n];
+		if( arg == "--to-unicode" ) {
+			direction = daw::rewrite_direction::to_unicode;
+		} else if( arg == "--to-ace" ) {
+			direction = daw::rewrite_direction::to_ace;
+		} else if( arg == "--threads" && n + 1 < argc ) {
+			thread_count = std::max<size_t>( 1, std::strtoul( argv[++n], nullptr, 10 ) );
+		} else if( !arg.empty( ) && arg[0] == '-' ) {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		} else {
+			paths.push_back( arg );
+		}
+	}
+	if( paths.size( ) > 2 ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	try {
+		std::ifstream in_file;
+		std::ofstream out_file;
+		if( paths.size( ) > 0 ) {
+			in_file.open( paths[0], std::ios::binary );
+			if( !in_file ) {
+				throw std::runtime_error( "Could not open " + paths[0] );
+			}
+		}
+		if( paths.size( ) > 1 ) {
+			out_file.open( paths[1], std::ios::binary );
+			if( !out_file ) {
+				throw std::runtime_error( "Could not open " + paths[1] );
+			}
+		}
+		std::istream & in = paths.size( ) > 0 ? in_file : std::cin;
+		std::ostream & out = paths.size( ) > 1 ? out_file : std::cout;
+		std::ios::sync_with_stdio( false );
+
+		// At most two blocks per thread are in flight, the oldest is always written first so output stays ordered
+		std::deque<std::future<block_result>> pending;
+		daw::rewrite_stats totals;
+		auto const write_oldest = [&]( ) {
+			auto result = pending.front( ).get( );
+			pending.pop_front( );
+			out.write( result.text.data( ), static_cast<std::streamsize>( result.text.size( ) ) );
+			totals.found += result.stats.found;
+			totals.rewritten += result.stats.rewritten;
+		};
+		std::unique_ptr<char[]> buffer( new char[BLOCK_SIZE] );
+		std::string carry;
+		std::string block;
+		while( next_block( in, buffer.get( ), carry, block ) ) {
+			if( pending.size( ) >= 2 * thread_count ) {
+				write_oldest( );
+			}
+			pending.push_back( std::async( std::launch::async, rewrite_block, std::move( block ), direction ) );
+			block.clear( );
+		}
+		while( !pending.empty( ) ) {
+			write_oldest( );
+		}
+		out.flush( );
+		if( !out ) {
+			throw std::runtime_error( "Error writing output" );
+		}
+		std::cerr << "Rewrote " << totals.rewritten << " of " << totals.found << " candidate hostnames\n";
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,521 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Serves to_puny_code/from_puny_code over a Unix domain socket so that one process per host can do the conversions
+// for every runtime.  A single epoll thread does all socket I/O and parses frames into a lock-free queue; a pool of
+// workers drains it in batches and hands results back through a second queue and an eventfd.  The label caches in the
+// library are process wide, so every worker shares them
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "mpmc_queue.h"
+#include "puny_coder.h"
+#include "puny_coder_sidecar.h"
+
+namespace {
+	constexpr size_t const QUEUE_CAPACITY = 1u << 16;
+	constexpr size_t const BATCH_SIZE = 64;
+	constexpr size_t const READ_SIZE = 64 * 1024;
+
+	struct job_t {
+		int fd = -1;
+		uint64_t generation = 0;
+		uint32_t id = 0;
+		uint8_t code = 0;
+		std::string payload;
+	};
+
+	struct connection_t {
+		int fd;
+		uint64_t generation;
+		std::vector<unsigned char> input;
+		std::string output;
+		size_t output_pos = 0;
+		bool writable_armed = false;
+		// Waiting for room in the request queue, so not reading
+		bool stalled = false;
+		// The peer shut down its side.  The connection stays open until its queued requests are answered and written
+		bool read_closed = false;
+		size_t in_flight = 0;
+	};
+
+	void throw_errno( char const * what ) {
+		throw std::runtime_error( std::string( what ) + ": " + std::strerror( errno ) );
+	}
+
+	class worker_pool {
+		daw::mpmc_queue<job_t> & m_requests;
+		daw::mpmc_queue<job_t> & m_responses;
+		int m_wakeup_fd;
+		std::atomic<bool> m_stop;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::vector<std::thread> m_threads;
+
+		static void convert( job_t & job ) {
+			try {
+				daw::string_view const input{ job.payload.data( ), job.payload.size( ) };
+				job.payload = job.code == static_cast<uint8_t>( daw::sidecar::operation::from_puny_code )
+				                ? daw::from_puny_code( input )
+				                : daw::to_puny_code( input );
+				job.code = static_cast<uint8_t>( daw::sidecar::status::ok );
+			} catch( std::exception const & ex ) {
+				job.payload = ex.what( );
+				job.code = static_cast<uint8_t>( daw::sidecar::status::error );
+			}
+			if( job.payload.size( ) > daw::sidecar::MAX_PAYLOAD_SIZE ) {
+				job.payload = "result too large";
+				job.code = static_cast<uint8_t>( daw::sidecar::status::error );
+			}
+		}
+
+		void run( ) {
+			std::vector<job_t> batch;
+			batch.reserve( BATCH_SIZE );
+			while( !m_stop.load( std::memory_order_relaxed ) ) {
+				job_t job;
+				while( batch.size( ) < BATCH_SIZE && m_requests.try_pop( job ) ) {
+					batch.push_back( std::move( job ) );
+				}
+				if( batch.empty( ) ) {
+					std::unique_lock<std::mutex> lock( m_mutex );
+					m_cv.wait_for( lock, std::chrono::milliseconds( 1 ), [&]( ) {
+						return m_stop.load( std::memory_order_relaxed ) || !m_requests.empty( );
+					} );
+					continue;
+				}
+				for( auto & j : batch ) {
+					convert( j );
+				}
+				for( auto & j : batch ) {
+					while( !m_responses.try_push( std::move( j ) ) ) {
+						std::this_thread::yield( );
+					}
+				}
+				batch.clear( );
+				uint64_t const one = 1;
+				if( write( m_wakeup_fd, &one, sizeof( one ) ) < 0 && errno != EAGAIN ) {
+					std::cerr << "eventfd write failed: " << std::strerror( errno ) << '\n';
+				}
+			}
+		}
+
+	public:
+		worker_pool( daw::mpmc_queue<job_t> & requests, daw::mpmc_queue<job_t> & responses, int wakeup_fd, size_t count )
+		  : m_requests( requests ), m_responses( responses ), m_wakeup_fd( wakeup_fd ), m_stop( false ) {
+			for( size_t n = 0; n < count; ++n ) {
+				m_threads.emplace_back( [this]( ) { run( ); } );
+			}
+		}
+
+		~worker_pool( ) {
+			m_stop = true;
+			m_cv.notify_all( );
+			for( auto & t : m_threads ) {
+				t.join( );
+			}
+		}
+
+		void notify( ) {
+			m_cv.notify_all( );
+		}
+	};
+
+	class server {
+		int m_epoll_fd;
+		int m_listen_fd;
+		int m_wakeup_fd;
+		int m_signal_fd;
+		uint64_t m_next_generation = 1;
+		std::unordered_map<int, connection_t> m_connections;
+		std::vector<int> m_stalled;
+		daw::mpmc_queue<job_t> m_requests;
+		daw::mpmc_queue<job_t> m_responses;
+
+		void watch( int fd, uint32_t events, int op ) {
+			epoll_event ev{ };
+			ev.events = events;
+			ev.data.fd = fd;
+			if( epoll_ctl( m_epoll_fd, op, fd, &ev ) < 0 ) {
+				throw_errno( "epoll_ctl" );
+			}
+		}
+
+		void accept_all( ) {
+			while( true ) {
+				auto const fd = accept4( m_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+				if( fd < 0 ) {
+					if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+						std::cerr << "accept failed: " << std::strerror( errno ) << '\n';
+					}
+					return;
+				}
+				m_connections[fd] = connection_t{ fd, m_next_generation++, { }, { }, 0, false };
+				watch( fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD );
+			}
+		}
+
+		static uint32_t events_for( connection_t const & conn ) noexcept {
+			uint32_t events = conn.writable_armed ? EPOLLOUT : 0u;
+			if( !conn.read_closed && !conn.stalled ) {
+				events |= EPOLLIN | EPOLLRDHUP;
+			}
+			return events;
+		}
+
+		static bool is_finished( connection_t const & conn ) noexcept {
+			return conn.read_closed && !conn.stalled && conn.in_flight == 0 && conn.output.empty( );
+		}
+
+		void close_connection( int fd ) {
+			epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr );
+			close( fd );
+			m_connections.erase( fd );
+		}
+
+		static bool is_operation( uint8_t code ) noexcept {
+			return code == static_cast<uint8_t>( daw::sidecar::operation::to_puny_code ) ||
+			       code == static_cast<uint8_t>( daw::sidecar::operation::from_puny_code );
+		}
+
+		static void append_response( connection_t & conn, uint32_t id, uint8_t code, std::string const & payload ) {
+			unsigned char header[daw::sidecar::HEADER_SIZE];
+			daw::sidecar::write_header( { id, code, static_cast<uint16_t>( payload.size( ) ) }, header );
+			conn.output.append( reinterpret_cast<char const *>( header ), sizeof( header ) );
+			conn.output.append( payload );
+		}
+
+		// Moves complete frames into the request queue and answers unknown operations directly.  Returns false when the queue is full and the connection has to
+		// wait for workers to catch up
+		bool parse_frames( connection_t & conn ) {
+			size_t pos = 0;
+			bool all_queued = true;
+			while( conn.input.size( ) - pos >= daw::sidecar::HEADER_SIZE ) {
+				auto const header = daw::sidecar::read_header( conn.input.data( ) + pos );
+				if( conn.input.size( ) - pos - daw::sidecar::HEADER_SIZE < header.size ) {
+					break;
+				}
+				auto const payload = reinterpret_cast<char const *>( conn.input.data( ) + pos + daw::sidecar::HEADER_SIZE );
+				if( !is_operation( header.code ) ) {
+					append_response( conn, header.id, static_cast<uint8_t>( daw::sidecar::status::error ), "unknown operation" );
+					pos += daw::sidecar::HEADER_SIZE + header.size;
+					continue;
+				}
+				job_t job;
+				job.fd = conn.fd;
+				job.generation = conn.generation;
+				job.id = header.id;
+				job.code = header.code;
+				job.payload.assign( payload, header.size );
+				if( !m_requests.try_push( std::move( job ) ) ) {
+					all_queued = false;
+					break;
+				}
+				++conn.in_flight;
+				pos += daw::sidecar::HEADER_SIZE + header.size;
+			}
+			conn.input.erase( conn.input.begin( ), conn.input.begin( ) + static_cast<std::ptrdiff_t>( pos ) );
+			return all_queued;
+		}
+
+		bool read_connection( connection_t & conn ) {
+			unsigned char buffer[READ_SIZE];
+			while( true ) {
+				auto const count = read( conn.fd, buffer, sizeof( buffer ) );
+				if( count == 0 ) {
+					// Half closed, answer what was already sent but read no more
+					conn.read_closed = true;
+					watch( conn.fd, events_for( conn ), EPOLL_CTL_MOD );
+					return true;
+				} else if( count < 0 ) {
+					if( errno == EINTR ) {
+						continue;
+					}
+					return errno == EAGAIN || errno == EWOULDBLOCK;
+				}
+				conn.input.insert( conn.input.end( ), buffer, buffer + count );
+				if( !parse_frames( conn ) ) {
+					// Stop reading until the queue drains; level triggered epoll will report it again
+					conn.stalled = true;
+					watch( conn.fd, events_for( conn ), EPOLL_CTL_MOD );
+					m_stalled.push_back( conn.fd );
+					return true;
+				}
+			}
+		}
+
+		bool flush( connection_t & conn ) {
+			while( conn.output_pos < conn.output.size( ) ) {
+				auto const count =
+				  write( conn.fd, conn.output.data( ) + conn.output_pos, conn.output.size( ) - conn.output_pos );
+				if( count < 0 ) {
+					if( errno == EINTR ) {
+						continue;
+					}
+					if( errno != EAGAIN && errno != EWOULDBLOCK ) {
+						return false;
+					}
+					break;
+				}
+				conn.output_pos += static_cast<size_t>( count );
+			}
+			if( conn.output_pos == conn.output.size( ) ) {
+				conn.output.clear( );
+				conn.output_pos = 0;
+			}
+			bool const want_write = !conn.output.empty( );
+			if( want_write != conn.writable_armed ) {
+				conn.writable_armed = want_write;
+				watch( conn.fd, events_for( conn ), EPOLL_CTL_MOD );
+			}
+			return true;
+		}
+
+		void drain_responses( ) {
+			uint64_t count = 0;
+			if( read( m_wakeup_fd, &count, sizeof( count ) ) < 0 && errno != EAGAIN ) {
+				throw_errno( "eventfd read" );
+			}
+			std::vector<int> touched;
+			job_t job;
+			while( m_responses.try_pop( job ) ) {
+				auto it = m_connections.find( job.fd );
+				if( it == m_connections.end( ) || it->second.generation != job.generation ) {
+					continue;
+				}
+				--it->second.in_flight;
+				append_response( it->second, job.id, job.code, job.payload );
+				touched.push_back( job.fd );
+			}
+			for( auto fd : touched ) {
+				auto it = m_connections.find( fd );
+				if( it != m_connections.end( ) && ( !flush( it->second ) || is_finished( it->second ) ) ) {
+					close_connection( fd );
+				}
+			}
+			// Room may have been made for connections that filled the request queue
+			auto stalled = std::move( m_stalled );
+			m_stalled.clear( );
+			for( auto fd : stalled ) {
+				auto it = m_connections.find( fd );
+				if( it == m_connections.end( ) ) {
+					continue;
+				}
+				if( parse_frames( it->second ) ) {
+					it->second.stalled = false;
+					watch( fd, events_for( it->second ), EPOLL_CTL_MOD );
+				} else {
+					m_stalled.push_back( fd );
+				}
+				// Unknown operations are answered while parsing
+				if( !it->second.output.empty( ) && !flush( it->second ) ) {
+					close_connection( fd );
+				}
+			}
+		}
+
+	public:
+		explicit server( std::string const & path )
+		  : m_epoll_fd( epoll_create1( EPOLL_CLOEXEC ) )
+		  , m_listen_fd( socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 ) )
+		  , m_wakeup_fd( eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) )
+		  , m_signal_fd( -1 )
+		  , m_requests( QUEUE_CAPACITY )
+		  , m_responses( QUEUE_CAPACITY ) {
+
+			if( m_epoll_fd < 0 || m_listen_fd < 0 || m_wakeup_fd < 0 ) {
+				throw_errno( "server setup" );
+			}
+			sockaddr_un addr{ };
+			addr.sun_family = AF_UNIX;
+			if( path.size( ) >= sizeof( addr.sun_path ) ) {
+				throw std::runtime_error( "Socket path is too long" );
+			}
+			std::copy( path.begin( ), path.end( ), addr.sun_path );
+			unlink( path.c_str( ) );
+			if( bind( m_listen_fd, reinterpret_cast<sockaddr *>( &addr ), sizeof( addr ) ) < 0 ) {
+				throw_errno( "bind" );
+			}
+			if( listen( m_listen_fd, SOMAXCONN ) < 0 ) {
+				throw_errno( "listen" );
+			}
+			sigset_t signals;
+			sigemptyset( &signals );
+			sigaddset( &signals, SIGINT );
+			sigaddset( &signals, SIGTERM );
+			pthread_sigmask( SIG_BLOCK, &signals, nullptr );
+			m_signal_fd = signalfd( -1, &signals, SFD_NONBLOCK | SFD_CLOEXEC );
+			if( m_signal_fd < 0 ) {
+				throw_errno( "signalfd" );
+			}
+			watch( m_listen_fd, EPOLLIN, EPOLL_CTL_ADD );
+			watch( m_wakeup_fd, EPOLLIN, EPOLL_CTL_ADD );
+			watch( m_signal_fd, EPOLLIN, EPOLL_CTL_ADD );
+		}
+
+		~server( ) {
+			for( auto & conn : m_connections ) {
+				close( conn.first );
+			}
+			close( m_signal_fd );
+			close( m_wakeup_fd );
+			close( m_listen_fd );
+			close( m_epoll_fd );
+		}
+
+		server( server const & ) = delete;
+		server & operator=( server const & ) = delete;
+
+		void run( size_t worker_count ) {
+			// Workers are created after the signal mask is set so they never receive SIGINT/SIGTERM themselves
+			worker_pool workers( m_requests, m_responses, m_wakeup_fd, worker_count );
+			std::vector<epoll_event> events( 256 );
+			while( true ) {
+				auto const count = epoll_wait( m_epoll_fd, events.data( ), static_cast<int>( events.size( ) ), -1 );
+				if( count < 0 ) {
+					if( errno == EINTR ) {
+						continue;
+					}
+					throw_errno( "epoll_wait" );
+				}
+				bool queued = false;
+				for( int n = 0; n < count; ++n ) {
+					auto const fd = events[static_cast<size_t>( n )].data.fd;
+					auto const ev = events[static_cast<size_t>( n )].events;
+					if( fd == m_signal_fd ) {
+						return;
+					} else if( fd == m_listen_fd ) {
+						accept_all( );
+					} else if( fd == m_wakeup_fd ) {
+						drain_responses( );
+					} else {
+						auto it = m_connections.find( fd );
+						if( it == m_connections.end( ) ) {
+							continue;
+						}
+						bool keep = true;
+						// A shut down peer is found by reading to the end, after any data still buffered
+						if( ev & ( EPOLLIN | EPOLLRDHUP ) ) {
+							keep = read_connection( it->second );
+							queued = true;
+						}
+						// Also sends the answers to unknown operations found while reading
+						if( keep && ( ( ev & EPOLLOUT ) || !it->second.output.empty( ) ) ) {
+							keep = flush( it->second );
+						}
+						if( !keep || ( ev & ( EPOLLERR | EPOLLHUP ) ) || is_finished( it->second ) ) {
+							close_connection( fd );
+						}
+					}
+				}
+				if( queued ) {
+					workers.notify( );
+				}
+			}
+		}
+	};
+
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " [--socket PATH] [--workers N] [--cache-entries N]\n";
+	}
+
+	// A whole decimal number.  std::stoul alone accepts "12abc" and wraps "-1" around
+	size_t parse_count( std::string const & option, std::string const & value ) {
+		size_t end = 0;
+		unsigned long result = 0;
+		if( !value.empty( ) && std::isdigit( static_cast<unsigned char>( value[0] ) ) ) {
+			try {
+				result = std::stoul( value, &end );
+			} catch( std::out_of_range const & ) {
+				end = 0;
+			}
+		}
+		if( end == 0 || end != value.size( ) ) {
+			throw std::invalid_argument( option + " expects a number, not '" + value + "'" );
+		}
+		return result;
+	}
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	std::string socket_path = "/tmp/puny_coder.sock";
+	size_t worker_count = std::max( 1u, std::thread::hardware_concurrency( ) );
+	try {
+		for( int n = 1; n < argc; n += 2 ) {
+			std::string const arg = argv[n];
+			if( n + 1 >= argc ) {
+				throw std::invalid_argument( arg + " expects a value" );
+			}
+			if( arg == "--socket" ) {
+				socket_path = argv[n + 1];
+			} else if( arg == "--workers" ) {
+				worker_count = parse_count( arg, argv[n + 1] );
+				if( worker_count == 0 ) {
+					throw std::invalid_argument( "--workers must be at least 1" );
+				}
+			} else if( arg == "--cache-entries" ) {
+				daw::set_label_cache_capacity( parse_count( arg, argv[n + 1] ) );
+			} else {
+				throw std::invalid_argument( "Unknown option " + arg );
+			}
+		}
+	} catch( std::invalid_argument const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	try {
+		server srv( socket_path );
+		std::cout << "Listening on " << socket_path << " with " << worker_count << " workers" << std::endl;
+		srv.run( worker_count );
+		unlink( socket_path.c_str( ) );
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,316 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Converts the domain names in a BIND style master zone file in one streaming pass.  Owner names, $ORIGIN and the
+// names in the RDATA of NS, CNAME, DNAME, PTR, MX, SRV and SOA records are converted label by label; everything
+// else, including comments, quoted strings, TTLs and layout, is copied unchanged.  Relative names stay relative,
+// conversion is per label so it does not depend on the origin they are relative to
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <daw/daw_string_view.h>
+
+#include "puny_coder.h"
+
+namespace {
+	enum class zone_direction { to_unicode, to_ace };
+
+	// Owner names repeat in long runs, and targets such as the zone's name servers repeat throughout
+	constexpr size_t const MAX_MEMOIZED_NAMES = 1u << 20;
+
+	void show_usage( char const * name ) {
+		std::cerr << "Usage: " << name << " [--to-unicode|--to-ace] [INPUT [OUTPUT]]\n"
+		          << "INPUT and OUTPUT default to stdin and stdout\n";
+	}
+
+	bool equal_nc( daw::string_view lhs, daw::string_view rhs ) noexcept {
+		return lhs.size( ) == rhs.size( ) && std::equal( lhs.begin( ), lhs.end( ), rhs.begin( ), []( char l, char r ) {
+			       return ( l >= 'a' && l <= 'z' ? l - 32 : l ) == r;
+		       } );
+	}
+
+	bool is_class( daw::string_view token ) noexcept {
+		return equal_nc( token, "IN" ) || equal_nc( token, "CH" ) || equal_nc( token, "HS" ) || equal_nc( token, "CS" );
+	}
+
+	bool is_ttl( daw::string_view token ) noexcept {
+		return !token.empty( ) && token[0] >= '0' && token[0] <= '9';
+	}
+
+	// Zero based positions of the RDATA fields holding domain names for the record types we convert
+	std::vector<size_t> name_fields( daw::string_view type ) {
+		if( equal_nc( type, "NS" ) || equal_nc( type, "CNAME" ) || equal_nc( type, "DNAME" ) || equal_nc( type, "PTR" ) ) {
+			return { 0 };
+		} else if( equal_nc( type, "MX" ) ) {
+			return { 1 };
+		} else if( equal_nc( type, "SRV" ) ) {
+			return { 3 };
+		} else if( equal_nc( type, "SOA" ) ) {
+			return { 0, 1 };
+		}
+		return { };
+	}
+
+	struct token_t {
+		size_t first;
+		size_t last;
+	};
+
+	class zone_converter {
+		zone_direction m_direction;
+		std::unordered_map<std::string, std::string> m_memo;
+		// Record state, which carries across lines inside parentheses
+		bool m_in_parens = false;
+		bool m_have_type = false;
+		std::vector<size_t> m_name_fields;
+		size_t m_rdata_field = 0;
+
+	public:
+		size_t names = 0;
+		size_t converted = 0;
+		size_t errors = 0;
+		size_t memo_hits = 0;
+
+		explicit zone_converter( zone_direction direction ) : m_direction( direction ) { }
+
+	private:
+		bool needs_conversion( daw::string_view label ) const noexcept {
+			if( m_direction == zone_direction::to_ace ) {
+				return std::any_of( label.begin( ), label.end( ), []( char c ) { return static_cast<unsigned char>( c ) >= 0x80; } );
+			}
+			return label.size( ) > 4 && equal_nc( label.substr( 0, 4 ), "XN--" );
+		}
+
+		// Each label goes through the label encode or decode path on its own, so labels such as _tcp or * that
+		// need no conversion are copied exactly
+		std::string convert_labels( daw::string_view name ) {
+			std::string result;
+			result.reserve( name.size( ) + 8 );
+			bool is_first = true;
+			for( auto const & label : daw::split( name, '.' ) ) {
+				if( !is_first ) {
+					result += '.';
+				}
+				is_first = false;
+				if( needs_conversion( label ) ) {
+					// from_puny_code accepts some malformed labels, an audit copy should not show what they decode to
+					if( m_direction == zone_direction::to_unicode ) {
+						auto const error = daw::validate_ace( label );
+						if( error != daw::ace_error::none && error != daw::ace_error::invalid_case ) {
+							throw std::runtime_error( daw::to_string( error ) );
+						}
+					}
+					result += m_direction == zone_direction::to_ace ? daw::to_puny_code( label ) : daw::from_puny_code( label );
+				} else {
+					result.append( label.data( ), label.size( ) );
+				}
+			}
+			return result;
+		}
+
+		void convert_name( daw::string_view name, size_t line_number, std::string & out ) {
+			++names;
+			// Escaped names (\. or \DDD) are left as they are
+			auto const labels = daw::split( name, '.' );
+			if( name == "@" || std::find( name.begin( ), name.end( ), '\\' ) != name.end( ) ||
+			    std::none_of( labels.begin( ), labels.end( ), [this]( daw::string_view label ) { return needs_conversion( label ); } ) ) {
+				out.append( name.data( ), name.size( ) );
+				return;
+			}
+			auto const key = name.to_string( );
+			auto const pos = m_memo.find( key );
+			if( pos != m_memo.end( ) ) {
+				++memo_hits;
+				++converted;
+				out += pos->second;
+				return;
+			}
+			try {
+				auto result = convert_labels( name );
+				out += result;
+				if( m_memo.size( ) >= MAX_MEMOIZED_NAMES ) {
+					m_memo.clear( );
+				}
+				m_memo.emplace( key, std::move( result ) );
+				++converted;
+			} catch( std::exception const & ex ) {
+				++errors;
+				std::cerr << "line " << line_number << ": could not convert " << key << ": " << ex.what( ) << '\n';
+				out.append( name.data( ), name.size( ) );
+			}
+		}
+
+		// Splits a line into tokens, parentheses are tokens of their own and a comment ends the line
+		static std::vector<token_t> tokenize( std::string const & line ) {
+			std::vector<token_t> result;
+			size_t pos = 0;
+			while( pos < line.size( ) ) {
+				auto const c = line[pos];
+				if( c == ' ' || c == '\t' || c == '\r' ) {
+					++pos;
+				} else if( c == ';' ) {
+					break;
+				} else if( c == '(' || c == ')' ) {
+					result.push_back( { pos, pos + 1 } );
+					++pos;
+				} else if( c == '"' ) {
+					auto const first = pos++;
+					while( pos < line.size( ) && line[pos] != '"' ) {
+						pos += line[pos] == '\\' ? 2 : 1;
+					}
+					pos = std::min( pos + 1, line.size( ) );
+					result.push_back( { first, pos } );
+				} else {
+					auto const first = pos;
+					while( pos < line.size( ) && !std::strchr( " \t\r;()\"", line[pos] ) ) {
+						pos += line[pos] == '\\' ? 2 : 1;
+					}
+					pos = std::min( pos, line.size( ) );
+					result.push_back( { first, pos } );
+				}
+			}
+			return result;
+		}
+
+	public:
+		std::string convert_line( std::string const & line, size_t line_number ) {
+			auto const tokens = tokenize( line );
+			std::string out;
+			out.reserve( line.size( ) + 16 );
+			size_t copied = 0;
+			auto const view = [&line]( token_t t ) {
+				return daw::string_view{ line.data( ) + t.first, t.last - t.first };
+			};
+			auto const replace = [&]( token_t t ) {
+				out.append( line, copied, t.first - copied );
+				convert_name( view( t ), line_number, out );
+				copied = t.last;
+			};
+
+			size_t n = 0;
+			if( !m_in_parens ) {
+				m_have_type = false;
+				m_rdata_field = 0;
+				m_name_fields.clear( );
+				if( !tokens.empty( ) && line[0] == '$' ) {
+					if( equal_nc( view( tokens[0] ), "$ORIGIN" ) && tokens.size( ) > 1 ) {
+						replace( tokens[1] );
+					}
+					out.append( line, copied, std::string::npos );
+					return out;
+				}
+				// An owner is only present when the line does not start with white space
+				if( !tokens.empty( ) && tokens[0].first == 0 && line[0] != '(' ) {
+					replace( tokens[0] );
+					n = 1;
+				}
+			}
+			for( ; n < tokens.size( ); ++n ) {
+				auto const token = view( tokens[n] );
+				if( token == "(" ) {
+					m_in_parens = true;
+				} else if( token == ")" ) {
+					m_in_parens = false;
+				} else if( !m_have_type ) {
+					if( !is_ttl( token ) && !is_class( token ) ) {
+						m_have_type = true;
+						m_name_fields = name_fields( token );
+					}
+				} else {
+					if( std::find( m_name_fields.begin( ), m_name_fields.end( ), m_rdata_field ) != m_name_fields.end( ) ) {
+						replace( tokens[n] );
+					}
+					++m_rdata_field;
+				}
+			}
+			out.append( line, copied, std::string::npos );
+			return out;
+		}
+	};
+}    // namespace anonymous
+
+int main( int argc, char ** argv ) {
+	auto direction = zone_direction::to_unicode;
+	std::vector<std::string> paths;
+	for( int n = 1; n < argc; ++n ) {
+		std::string const arg = argv[n];
+		if( arg == "--to-unicode" ) {
+			direction = zone_direction::to_unicode;
+		} else if( arg == "--to-ace" ) {
+			direction = zone_direction::to_ace;
+		} else if( !arg.empty( ) && arg[0] == '-' ) {
+			show_usage( argv[0] );
+			return EXIT_FAILURE;
+		} else {
+			paths.push_back( arg );
+		}
+	}
+	if( paths.size( ) > 2 ) {
+		show_usage( argv[0] );
+		return EXIT_FAILURE;
+	}
+	try {
+		std::ifstream in_file;
+		std::ofstream out_file;
+		if( paths.size( ) > 0 ) {
+			in_file.open( paths[0], std::ios::binary );
+			if( !in_file ) {
+				throw std::runtime_error( "Could not open " + paths[0] );
+			}
+		}
+		if( paths.size( ) > 1 ) {
+			out_file.open( paths[1], std::ios::binary );
+			if( !out_file ) {
+				throw std::runtime_error( "Could not open " + paths[1] );
+			}
+		}
+		std::istream & in = paths.size( ) > 0 ? in_file : std::cin;
+		std::ostream & out = paths.size( ) > 1 ? out_file : std::cout;
+		std::ios::sync_with_stdio( false );
+
+		zone_converter converter( direction );
+		std::string line;
+		size_t line_number = 0;
+		while( std::getline( in, line ) ) {
+			out << converter.convert_line( line, ++line_number ) << '\n';
+		}
+		out.flush( );
+		if( !out ) {
+			throw std::runtime_error( "Error writing output" );
+		}
+		std::cerr << "Converted " << converter.converted << " of " << converter.names << " names ("
+		          << converter.memo_hits << " memoized), " << converter.errors << " errors\n";
+		return converter.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	} catch( std::exception const & ex ) {
+		std::cerr << ex.what( ) << '\n';
+		return EXIT_FAILURE;
+	}
+}